@@ -0,0 +1,195 @@
+#include "arena.h"
+#include <cctype>
+#include <cstring>
+#include <dirent.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+namespace
+{
+constexpr size_t SMALL_PAGE = 4096;
+constexpr int MPOL_BIND_MODE = 2; // linux/mempolicy.h, not shipped with every libc
+
+size_t round_up(size_t value, size_t align)
+{
+    return (value + align - 1) / align * align;
+}
+
+// mmap flags asking for an explicit huge page size
+int huge_flags(PageBacking backing)
+{
+    int shift = backing == PageBacking::HUGE_1GB ? 30 : 21;
+    return MAP_HUGETLB | (shift << MAP_HUGE_SHIFT);
+}
+}
+
+const char *page_backing_name(PageBacking backing)
+{
+    switch (backing)
+    {
+    case PageBacking::SMALL:
+        return "4KB";
+    case PageBacking::TRANSPARENT:
+        return "THP";
+    case PageBacking::HUGE_2MB:
+        return "2MB";
+    case PageBacking::HUGE_1GB:
+        return "1GB";
+    }
+    return "?";
+}
+
+int numa_node_of_cpu(int cpu)
+{
+    string path = "/sys/devices/system/cpu/cpu" + to_string(cpu);
+    DIR *dir = opendir(path.c_str());
+    if (dir == nullptr)
+        return 0;
+
+    int node = 0;
+    while (dirent *entry = readdir(dir))
+    {
+        if (strncmp(entry->d_name, "node", 4) == 0 && isdigit(static_cast<unsigned char>(entry->d_name[4])))
+        {
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+int current_numa_node()
+{
+    int cpu = sched_getcpu();
+    return cpu < 0 ? 0 : numa_node_of_cpu(cpu);
+}
+
+size_t Arena::page_size(PageBacking backing)
+{
+    switch (backing)
+    {
+    case PageBacking::HUGE_1GB:
+        return size_t(1) << 30;
+    case PageBacking::HUGE_2MB:
+    case PageBacking::TRANSPARENT:
+        return size_t(2) << 20;
+    default:
+        return SMALL_PAGE;
+    }
+}
+
+Arena::Arena(size_t reserve_bytes, const ArenaConfig &config)
+    : mapping_(nullptr), mapping_size_(0), base_(nullptr), reserved_(0), committed_(0), config_(config),
+      backing_(config.pages), node_(-1)
+{
+    size_t align = page_size(config.pages);
+    reserved_ = round_up(max<size_t>(reserve_bytes, 1), align);
+
+    // Address space only; pages are mapped in as they are committed
+    mapping_size_ = reserved_ + align;
+    void *mapping = mmap(nullptr, mapping_size_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mapping == MAP_FAILED)
+    {
+        throw bad_alloc();
+    }
+    mapping_ = static_cast<char *>(mapping);
+    base_ = reinterpret_cast<char *>(round_up(reinterpret_cast<uintptr_t>(mapping_), align));
+
+    if (config.numa_node >= 0)
+    {
+        node_ = config.numa_node;
+    }
+    else if (config.numa_node == ArenaConfig::CALLER_NODE)
+    {
+        node_ = current_numa_node();
+    }
+}
+
+Arena::~Arena()
+{
+    if (mapping_)
+    {
+        munmap(mapping_, mapping_size_);
+    }
+}
+
+void Arena::bind(char *begin, size_t length)
+{
+    if (node_ < 0 || node_ >= 64)
+        return;
+
+    unsigned long mask = 1UL << node_;
+    if (syscall(SYS_mbind, begin, length, MPOL_BIND_MODE, &mask, sizeof(mask) * 8, 0) != 0)
+    {
+        node_ = -1;
+    }
+}
+
+bool Arena::commit(size_t bytes)
+{
+    if (bytes <= committed_)
+        return true;
+    if (bytes > reserved_)
+        return false;
+
+    // The reservation is a multiple of the requested page size, so rounding
+    // to the current backing never runs past it
+    size_t target = round_up(bytes, page_size(backing_));
+    char *begin = base_ + committed_;
+    size_t length = target - committed_;
+
+    // Explicit huge pages replace that stretch of the reservation outright
+    bool mapped = false;
+    while (!mapped && (backing_ == PageBacking::HUGE_1GB || backing_ == PageBacking::HUGE_2MB))
+    {
+        void *huge = mmap(begin, length, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | huge_flags(backing_), -1, 0);
+        if (huge != MAP_FAILED)
+        {
+            mapped = true;
+        }
+        else
+        {
+            backing_ = backing_ == PageBacking::HUGE_1GB && length % page_size(PageBacking::HUGE_2MB) == 0
+                           ? PageBacking::HUGE_2MB
+                           : PageBacking::TRANSPARENT;
+        }
+    }
+    if (!mapped)
+    {
+        // A failed MAP_FIXED may have dropped the reservation here, so map
+        // the stretch again rather than mprotect it
+        void *small = mmap(begin, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+        if (small == MAP_FAILED)
+            return false;
+        if (backing_ == PageBacking::TRANSPARENT && madvise(begin, length, MADV_HUGEPAGE) != 0)
+        {
+            backing_ = PageBacking::SMALL;
+        }
+    }
+
+    // Policy before the first touch, or the pages land wherever it happens
+    bind(begin, length);
+
+    if (config_.prefault && madvise(begin, length, MADV_POPULATE_WRITE) != 0)
+    {
+        // Kernels before 5.14: one write per small page
+        for (size_t offset = 0; offset < length; offset += SMALL_PAGE)
+        {
+            static_cast<volatile char *>(begin)[offset] = 0;
+        }
+    }
+
+    committed_ = target;
+    return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "types.h"
+
+// Page size an arena asks for. Explicit huge pages come from the hugetlbfs
+// pool (vm.nr_hugepages); when a commit cannot get them it falls back to
+// 2MB, then transparent huge pages, then small pages, and keeps going.
+enum class PageBacking : uint8_t
+{
+    SMALL,       // 4KB
+    TRANSPARENT, // 4KB mapping the kernel may back with 2MB THP (madvise)
+    HUGE_2MB,
+    HUGE_1GB,
+};
+
+const char *page_backing_name(PageBacking backing);
+
+struct ArenaConfig
+{
+    static constexpr int CALLER_NODE = -1; // the node of the CPU building the arena
+    static constexpr int ANY_NODE = -2;    // no binding, first touch decides
+
+    PageBacking pages = PageBacking::HUGE_2MB;
+    int numa_node = CALLER_NODE;
+    bool prefault = true; // touch every committed page up front, not on first use
+};
+
+// NUMA node of a CPU from sysfs; 0 on a machine without NUMA information
+int numa_node_of_cpu(int cpu);
+int current_numa_node();
+
+// One contiguous virtual reservation, committed front to back. Memory
+// below committed() is zero-filled and never moves, so growing keeps every
+// pointer into it valid. Each commit is bound to the arena's NUMA node and,
+// when prefault is set, faulted in before it returns, so the hot path never
+// takes a page fault on it. Binding is best effort: where the kernel
+// refuses mbind the arena runs unbound and numa_node() reports -1.
+class Arena
+{
+private:
+    char *mapping_;       // as returned by mmap, for munmap
+    size_t mapping_size_;
+    char *base_;          // mapping_ aligned to the requested page size
+    size_t reserved_;
+    size_t committed_;
+    ArenaConfig config_;
+    PageBacking backing_; // the weakest backing any commit got
+    int node_;
+
+    void bind(char *begin, size_t length);
+
+public:
+    Arena() : mapping_(nullptr), mapping_size_(0), base_(nullptr), reserved_(0), committed_(0),
+              backing_(PageBacking::SMALL), node_(-1) {}
+    // Reserves address space only; throws bad_alloc when there is none
+    Arena(size_t reserve_bytes, const ArenaConfig &config);
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    // Grows the committed prefix to at least bytes, in whole pages; false
+    // past the reservation or when the kernel refuses the memory
+    bool commit(size_t bytes);
+
+    char *data() const { return base_; }
+    size_t committed() const { return committed_; }
+    size_t reserved() const { return reserved_; }
+    PageBacking backing() const { return backing_; }
+    int numa_node() const { return node_; }
+
+    static size_t page_size(PageBacking backing);
+};
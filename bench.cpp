@@ -0,0 +1,808 @@
+#include "order_book.h"
+#include "object_pool.h"
+#include <array>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Microbenchmarks for the engine primitives, one JSON object per line so
+// runs can be diffed or gated by a script. `make bench BENCH_ARGS="..."`.
+
+struct BenchParams
+{
+    size_t depth = 100;        // price levels per side
+    size_t per_level = 10;     // resting orders per level
+    double cancel_ratio = 0.3; // share of book operations that are cancels
+    double iceberg_share = 0.1;
+    double stop_density = 1.0; // pending stops per price level
+    size_t ops = 1000000;
+    size_t rounds = 50; // book rebuilds for the sweep scenario
+    uint64_t seed = 42;
+    string only; // run scenarios whose name contains this
+};
+
+// Hardware counters for this thread, user space only. Any failure (no PMU,
+// perf_event_paranoid, containers) just leaves them unavailable.
+class PerfCounters
+{
+private:
+    static constexpr int COUNT = 3;
+    int fds_[COUNT];
+    bool available_;
+
+    static int open_counter(uint64_t config, int group_fd)
+    {
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.disabled = group_fd == -1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+    }
+
+public:
+    PerfCounters() : available_(true)
+    {
+        const uint64_t configs[COUNT] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                         PERF_COUNT_HW_CACHE_MISSES};
+        for (int i = 0; i < COUNT; i++)
+        {
+            fds_[i] = open_counter(configs[i], i == 0 ? -1 : fds_[0]);
+            available_ = available_ && fds_[i] >= 0;
+        }
+        if (available_)
+        {
+            ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+
+    ~PerfCounters()
+    {
+        for (int fd : fds_)
+        {
+            if (fd >= 0)
+                close(fd);
+        }
+    }
+
+    bool available() const { return available_; }
+
+    // cycles, instructions, cache misses
+    array<uint64_t, COUNT> read_all() const
+    {
+        array<uint64_t, COUNT> values{};
+        if (!available_)
+            return values;
+
+        uint64_t buffer[COUNT + 1] = {};
+        if (::read(fds_[0], buffer, sizeof(buffer)) == static_cast<ssize_t>(sizeof(buffer)))
+        {
+            for (int i = 0; i < COUNT; i++)
+            {
+                values[i] = buffer[i + 1];
+            }
+        }
+        return values;
+    }
+};
+
+// Accumulates time and counters over the resumed sections of one scenario
+class BenchTimer
+{
+private:
+    const PerfCounters &perf_;
+    uint64_t tsc_total_ = 0;
+    int64_t ns_total_ = 0;
+    array<uint64_t, 3> perf_total_{};
+    uint64_t tsc_start_ = 0;
+    int64_t ns_start_ = 0;
+    array<uint64_t, 3> perf_start_{};
+
+public:
+    explicit BenchTimer(const PerfCounters &perf) : perf_(perf) {}
+
+    void resume()
+    {
+        perf_start_ = perf_.read_all();
+        ns_start_ = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+        tsc_start_ = TscClock::ticks();
+    }
+
+    void pause()
+    {
+        uint64_t tsc_end = TscClock::ticks();
+        int64_t ns_end = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+        auto perf_end = perf_.read_all();
+        tsc_total_ += tsc_end - tsc_start_;
+        ns_total_ += ns_end - ns_start_;
+        for (size_t i = 0; i < perf_total_.size(); i++)
+        {
+            perf_total_[i] += perf_end[i] - perf_start_[i];
+        }
+    }
+
+    void report(const string &name, uint64_t ops, const BenchParams &params) const
+    {
+        double n = static_cast<double>(max<uint64_t>(ops, 1));
+        cout << fixed << setprecision(2)
+             << "{\"bench\":\"" << name << "\",\"ops\":" << ops
+             << ",\"ns_per_op\":" << ns_total_ / n
+             << ",\"tsc_per_op\":" << tsc_total_ / n;
+        if (perf_.available())
+        {
+            cout << ",\"cycles_per_op\":" << perf_total_[0] / n
+                 << ",\"instructions_per_op\":" << perf_total_[1] / n
+                 << ",\"cache_misses_per_op\":" << perf_total_[2] / n;
+        }
+        else
+        {
+            cout << ",\"cycles_per_op\":null,\"instructions_per_op\":null,\"cache_misses_per_op\":null";
+        }
+        cout << ",\"depth\":" << params.depth << ",\"per_level\":" << params.per_level
+             << ",\"cancel_ratio\":" << params.cancel_ratio << ",\"iceberg_share\":" << params.iceberg_share
+             << ",\"stop_density\":" << params.stop_density << ",\"seed\":" << params.seed << "}" << endl;
+    }
+};
+
+// Keeps results alive so the optimizer cannot drop the measured work
+static volatile int64_t bench_sink;
+
+static constexpr Price MID_PRICE = 100000;
+static constexpr Price TICK = 5; // tick of the default table around MID_PRICE
+static constexpr uint32_t AGGRESSOR = 99;
+
+static void setup_bench_limits(RiskManager &risk)
+{
+    RiskLimits limits = {
+        .max_position = LLONG_MAX / 4,
+        .max_order_value = LLONG_MAX / 4,
+        .max_order_qty = MAX_ORDER_QUANTITY,
+        .daily_loss_limit = LLONG_MAX / 4,
+        .max_price_deviation = 1.0,
+        .max_orders_per_sec = INT32_MAX,
+        .max_daily_volume = LLONG_MAX / 4};
+    for (uint32_t trader_id = 1; trader_id <= 100; ++trader_id)
+    {
+        risk.set_trader_limits(trader_id, limits);
+    }
+    risk.get_circuit_breaker().set_limits(MID_PRICE, 0.5);
+    risk.mark_to_market(MID_PRICE);
+}
+
+static unique_ptr<OrderBook> make_bench_book(size_t capacity)
+{
+    OrderBookConfig config;
+    config.order_pool_size = max<size_t>(capacity, 1024);
+    config.order_index_reserve = config.order_pool_size;
+    config.clock.source = ClockSource::SIMULATED;
+    auto book = make_unique<OrderBook>(config);
+    setup_bench_limits(book->get_risk_manager());
+
+    // CircuitBreaker rejects the first MARKET order it sees (price 0), take that hit here
+    book->add_order(1, Side::BUY, 0, 1, 1, 0, OrderType::MARKET, AGGRESSOR);
+    return book;
+}
+
+// Rests depth x per_level asks from MID_PRICE upwards, a share of them
+// icebergs, plus stop buys spread over the same levels
+static OrderId fill_asks(OrderBook &book, const BenchParams &params, mt19937_64 &rng, OrderId next_id)
+{
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    for (size_t level = 0; level < params.depth; level++)
+    {
+        Price price = MID_PRICE + static_cast<Price>(level) * TICK;
+        for (size_t i = 0; i < params.per_level; i++)
+        {
+            uint32_t owner = 1 + static_cast<uint32_t>(rng() % 50);
+            if (unit(rng) < params.iceberg_share)
+            {
+                book.add_order(next_id++, Side::SELL, price, 100, 20, 20, OrderType::ICEBERG, owner);
+            }
+            else
+            {
+                book.add_order(next_id++, Side::SELL, price, 100, 100, 0, OrderType::GTC, owner);
+            }
+        }
+    }
+
+    size_t stops = static_cast<size_t>(params.stop_density * params.depth);
+    for (size_t i = 0; i < stops; i++)
+    {
+        Price stop = MID_PRICE + static_cast<Price>(rng() % max<size_t>(params.depth, 1)) * TICK;
+        uint32_t owner = 51 + static_cast<uint32_t>(rng() % 40);
+        book.add_order(next_id++, Side::BUY, 0, 10, 10, 0, OrderType::STOP_LOSS, owner, stop);
+    }
+    return next_id;
+}
+
+static void bench_price_level(const BenchParams &params, const PerfCounters &perf)
+{
+    size_t count = max<size_t>(params.per_level, 2);
+    OrderStore store(count);
+    PriceLevel level;
+    vector<Order *> orders;
+    for (size_t i = 0; i < count; i++)
+    {
+        Order *order = store.acquire();
+        order->id = i + 1;
+        level.add_order(store, order);
+        orders.push_back(order);
+    }
+
+    mt19937_64 rng(params.seed);
+    vector<uint32_t> picks(4096);
+    for (auto &pick : picks)
+    {
+        pick = static_cast<uint32_t>(rng() % count);
+    }
+
+    // Erase from anywhere in the queue, re-queue at the back to keep the size
+    BenchTimer timer(perf);
+    timer.resume();
+    for (size_t op = 0; op < params.ops; op++)
+    {
+        Order *order = orders[picks[op & 4095]];
+        level.erase(store, order);
+        level.add_order(store, order);
+    }
+    timer.pause();
+    bench_sink = level.front(store)->id;
+    timer.report("price_level_erase_requeue", params.ops, params);
+}
+
+// Steady state with a random live set: release one, acquire one
+template <typename Pool, typename T>
+static void bench_pool(const string &name, Pool &pool, size_t live_count, const BenchParams &params,
+                       const PerfCounters &perf)
+{
+    vector<T *> live;
+    for (size_t i = 0; i < live_count; i++)
+    {
+        live.push_back(pool.acquire());
+    }
+
+    mt19937_64 rng(params.seed);
+    vector<uint32_t> picks(4096);
+    for (auto &pick : picks)
+    {
+        pick = static_cast<uint32_t>(rng() % live_count);
+    }
+
+    BenchTimer timer(perf);
+    timer.resume();
+    for (size_t op = 0; op < params.ops; op++)
+    {
+        T *&slot = live[picks[op & 4095]];
+        pool.release(slot);
+        slot = pool.acquire();
+    }
+    timer.pause();
+    bench_sink = reinterpret_cast<intptr_t>(live[0]);
+    timer.report(name, params.ops, params);
+
+    for (T *obj : live)
+    {
+        pool.release(obj);
+    }
+}
+
+static void bench_pools(const BenchParams &params, const PerfCounters &perf)
+{
+    size_t live = max<size_t>(params.depth * params.per_level, 1);
+    OrderStore store(live + 1);
+    bench_pool<OrderStore, Order>("order_store_acquire_release", store, live, params, perf);
+
+    ObjectPool<Trade, SingleThreadPool> trades(live + 1);
+    bench_pool<ObjectPool<Trade, SingleThreadPool>, Trade>("object_pool_acquire_release", trades, live, params, perf);
+
+    // A default-sized book store built from nothing, pages committed and
+    // pre-faulted; one op is one construction
+    const size_t startup_rounds = 3;
+    BenchTimer startup(perf);
+    for (size_t round = 0; round < startup_rounds; round++)
+    {
+        startup.resume();
+        OrderStore full(OrderBookConfig{}.order_pool_size);
+        startup.pause();
+        bench_sink = static_cast<intptr_t>(full.total_capacity());
+    }
+    startup.report("order_store_startup", startup_rounds, params);
+}
+
+static void bench_tick_table(const BenchParams &params, const PerfCounters &perf)
+{
+    TickSizeTable table;
+    mt19937_64 rng(params.seed);
+    vector<Price> prices(4096);
+    for (auto &price : prices)
+    {
+        price = 1 + static_cast<Price>(rng() % 2000000);
+    }
+
+    BenchTimer round_timer(perf);
+    int64_t sum = 0;
+    round_timer.resume();
+    for (size_t op = 0; op < params.ops; op++)
+    {
+        sum += table.round_to_tick(prices[op & 4095]);
+    }
+    round_timer.pause();
+    bench_sink = sum;
+    round_timer.report("tick_round_to_tick", params.ops, params);
+
+    for (auto &price : prices)
+    {
+        price = table.round_to_tick(price);
+    }
+    BenchTimer index_timer(perf);
+    index_timer.resume();
+    for (size_t op = 0; op < params.ops; op++)
+    {
+        sum += table.tick_index(prices[op & 4095]);
+    }
+    index_timer.pause();
+    bench_sink = sum;
+    index_timer.report("tick_index", params.ops, params);
+}
+
+static void bench_stops(const BenchParams &params, const PerfCounters &perf)
+{
+    size_t per_side = max<size_t>(static_cast<size_t>(params.stop_density * params.depth), 1);
+    OrderStore store(2 * per_side + 1);
+    mt19937_64 rng(params.seed);
+
+    // Buy stops above the market, sell stops below, none crossed by MID_PRICE
+    auto stop_price = [&](Side side)
+    {
+        Price offset = static_cast<Price>(1 + rng() % max<size_t>(params.depth, 1)) * TICK;
+        return side == Side::BUY ? MID_PRICE + offset : MID_PRICE - offset;
+    };
+
+    StopOrderManager stops;
+    vector<pair<Order *, Price>> pending;
+    for (size_t i = 0; i < 2 * per_side; i++)
+    {
+        Order *order = store.acquire();
+        order->id = i + 1;
+        order->type = OrderType::STOP_LOSS;
+        order->side = i % 2 ? Side::SELL : Side::BUY;
+        pending.emplace_back(order, stop_price(order->side));
+    }
+
+    BenchTimer add_timer(perf);
+    add_timer.resume();
+    for (auto &[order, price] : pending)
+    {
+        store.cold(order).stop_slot = stops.add_stop_order(order, price);
+    }
+    add_timer.pause();
+    add_timer.report("stop_add", pending.size(), params);
+
+    BenchTimer idle_timer(perf);
+    idle_timer.resume();
+    for (size_t op = 0; op < params.ops; op++)
+    {
+        bench_sink = stops.check_triggered_stops(MID_PRICE + static_cast<Price>(op & 1)).size();
+    }
+    idle_timer.pause();
+    idle_timer.report("stop_check_idle", params.ops, params);
+
+    BenchTimer cancel_timer(perf);
+    size_t cancels = static_cast<size_t>(params.cancel_ratio * pending.size());
+    cancel_timer.resume();
+    for (size_t i = 0; i < cancels; i++)
+    {
+        Order *order = pending[i].first;
+        stops.remove_stop_order(order, store.cold(order).stop_slot);
+    }
+    cancel_timer.pause();
+    cancel_timer.report("stop_cancel", cancels, params);
+
+    // Sweep every remaining buy stop, then every sell stop
+    size_t remaining = stops.pending_stop_count();
+    BenchTimer trigger_timer(perf);
+    trigger_timer.resume();
+    size_t fired = stops.check_triggered_stops(LLONG_MAX / 2).size();
+    fired += stops.check_triggered_stops(1).size();
+    trigger_timer.pause();
+    bench_sink = fired;
+    trigger_timer.report("stop_trigger", max<size_t>(remaining, 1), params);
+}
+
+static void bench_risk(const BenchParams &params, const PerfCounters &perf)
+{
+    RiskManager risk;
+    setup_bench_limits(risk);
+
+    mt19937_64 rng(params.seed);
+    vector<pair<Order, OrderCold>> orders(4096);
+    for (auto &[order, cold] : orders)
+    {
+        order.ownerID = 1 + static_cast<uint32_t>(rng() % 100);
+        order.side = rng() % 2 ? Side::BUY : Side::SELL;
+        order.type = OrderType::GTC;
+        cold.price = MID_PRICE + static_cast<Price>(rng() % 200) - 100;
+        cold.quantity = 1 + static_cast<Quantity>(rng() % 500);
+    }
+
+    BenchTimer timer(perf);
+    int64_t approved = 0;
+    timer.resume();
+    for (size_t op = 0; op < params.ops; op++)
+    {
+        auto &[order, cold] = orders[op & 4095];
+        cold.timestamp = static_cast<int64_t>(op) * 1000;
+        approved += risk.check_static(order.ownerID, order.type, cold.price, cold.quantity) ==
+                        RiskManager::RiskResult::APPROVED &&
+                    risk.check_order(order, cold) == RiskManager::RiskResult::APPROVED;
+    }
+    timer.pause();
+    bench_sink = approved;
+    timer.report("risk_check_order", params.ops, params);
+}
+
+static void bench_market_sweep(const BenchParams &params, const PerfCounters &perf)
+{
+    mt19937_64 rng(params.seed);
+    size_t resting = params.depth * params.per_level;
+    size_t stops = static_cast<size_t>(params.stop_density * params.depth);
+
+    BenchTimer timer(perf);
+    for (size_t round = 0; round < params.rounds; round++)
+    {
+        auto book = make_bench_book(resting + stops + 16);
+        OrderId next_id = fill_asks(*book, params, rng, 2);
+
+        // Enough to take every visible and hidden share on the book
+        Quantity sweep = static_cast<Quantity>(resting) * 100;
+        timer.resume();
+        ExecutionReport report = book->add_order(next_id, Side::BUY, 0, sweep, sweep, 0, OrderType::MARKET,
+                                                 AGGRESSOR, 0, 0, [](const Trade &) {});
+        timer.pause();
+        bench_sink = report.trade_count;
+    }
+    timer.report("market_sweep", params.rounds, params);
+}
+
+// All-or-none orders one share more than the whole ask side shows, with a
+// limit through every level: each is cancelled and the book never changes
+static void bench_all_or_none(const BenchParams &params, const PerfCounters &perf)
+{
+    mt19937_64 rng(params.seed);
+    size_t resting = params.depth * params.per_level;
+    size_t stops = static_cast<size_t>(params.stop_density * params.depth);
+    auto book = make_bench_book(resting + stops + 16);
+    OrderId next_id = fill_asks(*book, params, rng, 2);
+
+    vector<L2Level> depth;
+    book->get_depth(Side::SELL, params.depth, depth);
+    int64_t visible = 0;
+    for (const L2Level &level : depth)
+    {
+        visible += level.quantity;
+    }
+    Quantity quantity = static_cast<Quantity>(visible + 1);
+    Price limit = MID_PRICE + static_cast<Price>(params.depth) * TICK;
+
+    for (OrderType type : {OrderType::FOK, OrderType::AON_IOC})
+    {
+        BenchTimer timer(perf);
+        int64_t cancelled = 0;
+        timer.resume();
+        for (size_t op = 0; op < params.ops; op++)
+        {
+            ExecutionReport report = book->add_order(next_id++, Side::BUY, limit, quantity, quantity, 0, type,
+                                                     AGGRESSOR, 0, 0, [](const Trade &) {});
+            cancelled += report.status == ExecStatus::CANCELLED;
+        }
+        timer.pause();
+        bench_sink = cancelled;
+        timer.report(type == OrderType::FOK ? "fok_reject" : "aon_ioc_reject", params.ops, params);
+    }
+}
+
+// Steady book under a stream of non-crossing adds, with cancel_ratio of
+// operations cancelling a random resting order instead
+static void bench_add_cancel(const BenchParams &params, const PerfCounters &perf)
+{
+    mt19937_64 rng(params.seed);
+    size_t resting = params.depth * params.per_level;
+    auto book = make_bench_book(2 * resting + params.ops + 16);
+    OrderId next_id = fill_asks(*book, params, rng, 2);
+
+    struct BookOp
+    {
+        bool cancel;
+        OrderId id;
+        Price price;
+        bool iceberg;
+    };
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    vector<OrderId> live;
+    for (OrderId id = 2; id < next_id; id++)
+    {
+        live.push_back(id);
+    }
+
+    vector<BookOp> tape;
+    tape.reserve(params.ops);
+    for (size_t op = 0; op < params.ops; op++)
+    {
+        if (!live.empty() && unit(rng) < params.cancel_ratio)
+        {
+            size_t pick = rng() % live.size();
+            tape.push_back(BookOp{true, live[pick], 0, false});
+            live[pick] = live.back();
+            live.pop_back();
+        }
+        else
+        {
+            Price price = MID_PRICE + static_cast<Price>(rng() % max<size_t>(params.depth, 1)) * TICK;
+            tape.push_back(BookOp{false, next_id, price, unit(rng) < params.iceberg_share});
+            live.push_back(next_id++);
+        }
+    }
+
+    BenchTimer timer(perf);
+    timer.resume();
+    for (const BookOp &op : tape)
+    {
+        if (op.cancel)
+        {
+            bench_sink = book->cancel_order(op.id);
+        }
+        else if (op.iceberg)
+        {
+            bench_sink = book->add_order(op.id, Side::SELL, op.price, 100, 20, 20, OrderType::ICEBERG, 7, 0, 0,
+                                         [](const Trade &) {})
+                             .leaves_quantity;
+        }
+        else
+        {
+            bench_sink = book->add_order(op.id, Side::SELL, op.price, 100, 100, 0, OrderType::GTC, 7, 0, 0,
+                                         [](const Trade &) {})
+                             .leaves_quantity;
+        }
+    }
+    timer.pause();
+    timer.report("book_add_cancel", tape.size(), params);
+}
+
+static void bench_depth_snapshot(const BenchParams &params, const PerfCounters &perf)
+{
+    mt19937_64 rng(params.seed);
+    auto book = make_bench_book(params.depth * params.per_level + params.depth + 16);
+    fill_asks(*book, params, rng, 2);
+
+    vector<L2Level> levels;
+    levels.reserve(10);
+    BenchTimer timer(perf);
+    timer.resume();
+    for (size_t op = 0; op < params.ops; op++)
+    {
+        bench_sink = book->get_depth(Side::SELL, 10, levels);
+    }
+    timer.pause();
+    timer.report("depth_snapshot_top10", params.ops, params);
+}
+
+// One owner re-quoting a ladder of bids under the resting asks, as
+// cancel/add pairs and as replace_quotes batches
+static void bench_quotes(const BenchParams &params, const PerfCounters &perf)
+{
+    constexpr size_t QUOTES = 10;
+    constexpr uint32_t QUOTER = 98;
+    size_t batches = max<size_t>(params.ops / QUOTES, 1);
+
+    auto run = [&](const char *name, bool batched)
+    {
+        mt19937_64 rng(params.seed);
+        auto book = make_bench_book(params.depth * params.per_level + params.depth + 2 * QUOTES + 16);
+        OrderId next_id = fill_asks(*book, params, rng, 2);
+
+        vector<QuoteUpdate> quotes(QUOTES);
+        for (size_t i = 0; i < QUOTES; i++)
+        {
+            quotes[i] = QuoteUpdate{0, 0, Side::BUY, 0, 100};
+        }
+
+        BenchTimer timer(perf);
+        for (size_t batch = 0; batch < batches; batch++)
+        {
+            Price shift = static_cast<Price>(batch & 1) * TICK;
+            for (size_t i = 0; i < QUOTES; i++)
+            {
+                quotes[i].replaces_id = quotes[i].id;
+                quotes[i].id = next_id++;
+                quotes[i].price = MID_PRICE - static_cast<Price>(i + 1) * TICK - shift;
+            }
+
+            timer.resume();
+            if (batched)
+            {
+                bench_sink = book->replace_quotes(QUOTER, 0, quotes.data(), QUOTES, [](const Trade &) {}).resting;
+            }
+            else
+            {
+                for (const QuoteUpdate &quote : quotes)
+                {
+                    if (quote.replaces_id != 0)
+                    {
+                        book->cancel_order(quote.replaces_id);
+                    }
+                    bench_sink = book->add_order(quote.id, quote.side, quote.price, quote.quantity, quote.quantity, 0,
+                                                 OrderType::GTC, QUOTER, 0, 0, [](const Trade &) {})
+                                     .leaves_quantity;
+                }
+            }
+            timer.pause();
+        }
+        timer.report(name, batches * QUOTES, params);
+    };
+    run("quote_replace_serial", false);
+    run("quote_replace_batch", true);
+}
+
+// Amending random resting asks: size-down in place, a move to another
+// level, and the cancel plus re-add a client would otherwise send
+static void bench_modify(const BenchParams &params, const PerfCounters &perf)
+{
+    auto run = [&](const char *name, int mode)
+    {
+        mt19937_64 rng(params.seed);
+        auto book = make_bench_book(params.depth * params.per_level + params.depth + 16);
+        OrderId next_id = fill_asks(*book, params, rng, 2);
+
+        // fill_asks rests ids 2.. level by level; nothing crosses, so every
+        // order stays live wherever it is moved within the ask range
+        vector<pair<OrderId, Price>> live;
+        for (size_t i = 0; i < params.depth * params.per_level; i++)
+        {
+            live.emplace_back(2 + i, MID_PRICE + static_cast<Price>(i / params.per_level) * TICK);
+        }
+
+        // Size-downs go round robin, one share at a time, so each stays a size-down
+        size_t ops = mode == 0 ? min(params.ops, live.size() * 99) : params.ops;
+        BenchTimer timer(perf);
+        timer.resume();
+        for (size_t op = 0; op < ops; op++)
+        {
+            if (mode == 0)
+            {
+                const auto &[id, price] = live[op % live.size()];
+                Quantity quantity = 99 - static_cast<Quantity>(op / live.size());
+                bench_sink = book->modify_order(id, price, quantity, [](const Trade &) {}).leaves_quantity;
+                continue;
+            }
+
+            auto &[id, price] = live[rng() % live.size()];
+            Price moved = MID_PRICE + static_cast<Price>(rng() % max<size_t>(params.depth, 1)) * TICK;
+            if (mode == 1)
+            {
+                bench_sink = book->modify_order(id, moved, 100, [](const Trade &) {}).leaves_quantity;
+            }
+            else
+            {
+                book->cancel_order(id);
+                id = next_id++;
+                bench_sink = book->add_order(id, Side::SELL, moved, 100, 100, 0, OrderType::GTC, 7, 0, 0,
+                                             [](const Trade &) {})
+                                 .leaves_quantity;
+            }
+            price = moved;
+        }
+        timer.pause();
+        timer.report(name, ops, params);
+    };
+    run("modify_size_down", 0);
+    run("modify_reprice", 1);
+    run("cancel_replace", 2);
+}
+
+// Every owner on a full book pulls all of its orders
+static void bench_mass_cancel(const BenchParams &params, const PerfCounters &perf)
+{
+    mt19937_64 rng(params.seed);
+    size_t resting = params.depth * params.per_level;
+    size_t stops = static_cast<size_t>(params.stop_density * params.depth);
+
+    BenchTimer timer(perf);
+    size_t cancelled = 0;
+    for (size_t round = 0; round < params.rounds; round++)
+    {
+        auto book = make_bench_book(resting + stops + 16);
+        fill_asks(*book, params, rng, 2);
+
+        timer.resume();
+        for (uint32_t owner = 1; owner <= 90; owner++)
+        {
+            cancelled += book->cancel_all_orders(owner);
+        }
+        timer.pause();
+    }
+    bench_sink = static_cast<int64_t>(cancelled);
+    timer.report("mass_cancel_owner", max<size_t>(cancelled, 1), params);
+}
+
+static void usage()
+{
+    cerr << "usage: engine_bench [--depth N] [--per-level N] [--cancel-ratio F] [--iceberg-share F]\n"
+         << "                    [--stop-density F] [--ops N] [--rounds N] [--seed N] [--only NAME]" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    BenchParams params;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+        string value = argv[++i];
+        if (arg == "--depth")
+            params.depth = stoull(value);
+        else if (arg == "--per-level")
+            params.per_level = stoull(value);
+        else if (arg == "--cancel-ratio")
+            params.cancel_ratio = stod(value);
+        else if (arg == "--iceberg-share")
+            params.iceberg_share = stod(value);
+        else if (arg == "--stop-density")
+            params.stop_density = stod(value);
+        else if (arg == "--ops")
+            params.ops = stoull(value);
+        else if (arg == "--rounds")
+            params.rounds = stoull(value);
+        else if (arg == "--seed")
+            params.seed = stoull(value);
+        else if (arg == "--only")
+            params.only = value;
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if (params.depth == 0 || params.per_level == 0 || params.ops == 0)
+    {
+        usage();
+        return 1;
+    }
+
+    PerfCounters perf;
+    if (!perf.available())
+    {
+        cerr << "note: hardware counters unavailable, reporting TSC ticks only" << endl;
+    }
+
+    const pair<const char *, void (*)(const BenchParams &, const PerfCounters &)> scenarios[] = {
+        {"price_level", bench_price_level},
+        {"pool", bench_pools},
+        {"tick", bench_tick_table},
+        {"stop", bench_stops},
+        {"risk", bench_risk},
+        {"market_sweep", bench_market_sweep},
+        {"all_or_none", bench_all_or_none},
+        {"book_add_cancel", bench_add_cancel},
+        {"depth_snapshot", bench_depth_snapshot},
+        {"quote_replace", bench_quotes},
+        {"modify", bench_modify},
+        {"mass_cancel", bench_mass_cancel},
+    };
+    for (const auto &[name, run] : scenarios)
+    {
+        if (params.only.empty() || string(name).find(params.only) != string::npos)
+        {
+            run(params, perf);
+        }
+    }
+    return 0;
+}
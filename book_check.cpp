@@ -0,0 +1,367 @@
+#include "order_book.h"
+#include <unistd.h>
+
+// Deterministic checks of book behaviour that replay checksums do not pin
+// down: iceberg bookkeeping, FOK pre-checks, tick validation, the counters.
+// `make check`; prints each failed expectation and exits non-zero if any.
+
+static int failures = 0;
+
+#define CHECK(cond)                                                           \
+    do                                                                        \
+    {                                                                         \
+        if (!(cond))                                                          \
+        {                                                                     \
+            cerr << "  " << __FILE__ << ":" << __LINE__ << ": " #cond << endl; \
+            failures++;                                                       \
+        }                                                                     \
+    } while (0)
+
+static constexpr Price MID_PRICE = 100000;
+static constexpr uint32_t SELLER = 1;
+static constexpr uint32_t BUYER = 2;
+static constexpr uint32_t OTHER = 3;
+
+// Collects every trade of one message
+struct Fills
+{
+    vector<Trade> trades;
+
+    void operator()(const Trade &trade) { trades.push_back(trade); }
+
+    Quantity volume() const
+    {
+        Quantity total = 0;
+        for (const Trade &trade : trades)
+        {
+            total += trade.quantity;
+        }
+        return total;
+    }
+};
+
+static unique_ptr<OrderBook> make_check_book()
+{
+    OrderBookConfig config;
+    config.order_pool_size = 1024;
+    config.clock.source = ClockSource::SIMULATED;
+    auto book = make_unique<OrderBook>(config);
+
+    RiskLimits limits = {
+        .max_position = LLONG_MAX / 4,
+        .max_order_value = LLONG_MAX / 4,
+        .max_order_qty = MAX_ORDER_QUANTITY,
+        .daily_loss_limit = LLONG_MAX / 4,
+        .max_price_deviation = 1.0,
+        .max_orders_per_sec = INT32_MAX,
+        .max_daily_volume = LLONG_MAX / 4};
+    RiskManager &risk = book->get_risk_manager();
+    for (uint32_t trader_id = 1; trader_id <= 10; ++trader_id)
+    {
+        risk.set_trader_limits(trader_id, limits);
+    }
+    risk.get_circuit_breaker().set_limits(MID_PRICE, 0.5);
+    risk.mark_to_market(MID_PRICE);
+
+    // CircuitBreaker rejects the first MARKET order it sees (price 0), take that hit here
+    book->add_order(1, Side::BUY, 0, 1, 1, 0, OrderType::MARKET, OTHER);
+    return book;
+}
+
+static Quantity sweep(OrderBook &book, OrderId id, Side side, Quantity qty, uint32_t owner)
+{
+    Fills fills;
+    book.add_order(id, side, 0, qty, qty, 0, OrderType::MARKET, owner, 0, 0, fills);
+    return fills.volume();
+}
+
+// A refilled iceberg sized down keeps exactly the new size
+static void check_refilled_iceberg_size_down()
+{
+    auto book = make_check_book();
+    Fills fills;
+    book->add_order(10, Side::SELL, MID_PRICE, 1000, 100, 100, OrderType::ICEBERG, SELLER, 0, 0, fills);
+    book->add_order(11, Side::BUY, MID_PRICE, 100, 100, 0, OrderType::GTC, BUYER, 0, 0, fills);
+    CHECK(fills.volume() == 100);
+
+    ExecutionReport report = book->modify_order(10, MID_PRICE, 500, fills);
+    CHECK(report.status == ExecStatus::RESTING);
+    CHECK(report.leaves_quantity == 500);
+
+    CHECK(sweep(*book, 12, Side::BUY, 1000, BUYER) == 500);
+    CHECK(book->ask_levels() == 0);
+    CHECK(book->order_count() == 0);
+}
+
+// A size-down of a refilled iceberg is in place: it stays ahead of a later order
+static void check_refilled_iceberg_keeps_priority()
+{
+    auto book = make_check_book();
+    Fills fills;
+    book->add_order(20, Side::SELL, MID_PRICE, 1000, 100, 100, OrderType::ICEBERG, SELLER, 0, 0, fills);
+    book->add_order(21, Side::BUY, MID_PRICE, 100, 100, 0, OrderType::GTC, BUYER, 0, 0, fills);
+    book->add_order(22, Side::SELL, MID_PRICE, 100, 100, 0, OrderType::GTC, OTHER, 0, 0, fills);
+
+    // 900 left after the first fill, so 850 is a size-down
+    ExecutionReport report = book->modify_order(20, MID_PRICE, 850, fills);
+    CHECK(report.status == ExecStatus::RESTING);
+
+    Fills next;
+    book->add_order(23, Side::BUY, MID_PRICE, 100, 100, 0, OrderType::GTC, BUYER, 0, 0, next);
+    CHECK(next.trades.size() == 1 && next.trades[0].sell_id == 20);
+
+    CHECK(sweep(*book, 24, Side::BUY, 2000, BUYER) == 850);
+}
+
+// An iceberg that trades on entry rests with what is left of its total
+static void check_aggressor_iceberg_rests_remainder()
+{
+    auto book = make_check_book();
+    Fills fills;
+    book->add_order(30, Side::SELL, MID_PRICE, 50, 50, 0, OrderType::GTC, SELLER, 0, 0, fills);
+    ExecutionReport report =
+        book->add_order(31, Side::BUY, MID_PRICE, 1000, 100, 100, OrderType::ICEBERG, BUYER, 0, 0, fills);
+    CHECK(report.status == ExecStatus::PARTIALLY_FILLED);
+    CHECK(report.filled_quantity == 50);
+    CHECK(report.leaves_quantity == 950);
+
+    CHECK(sweep(*book, 32, Side::SELL, 2000, OTHER) == 950);
+    CHECK(book->bid_levels() == 0);
+}
+
+// An aggressor iceberg that trades its whole display crosses on from its
+// reserve, then rests the rest of it
+static void check_aggressor_iceberg_refills()
+{
+    auto book = make_check_book();
+    Fills fills;
+    book->add_order(35, Side::SELL, MID_PRICE, 250, 250, 0, OrderType::GTC, SELLER, 0, 0, fills);
+    Fills crossed;
+    ExecutionReport report =
+        book->add_order(36, Side::BUY, MID_PRICE, 1000, 100, 100, OrderType::ICEBERG, BUYER, 0, 0, crossed);
+    CHECK(crossed.volume() == 250);
+    CHECK(report.status == ExecStatus::PARTIALLY_FILLED);
+    CHECK(report.filled_quantity == 250);
+    CHECK(report.leaves_quantity == 750);
+    CHECK(book->order_count() == 1 && book->best_bid() == MID_PRICE);
+
+    // Used up before any slice rests
+    book->add_order(37, Side::SELL, MID_PRICE + 5, 300, 300, 0, OrderType::GTC, SELLER, 0, 0, fills);
+    report = book->add_order(38, Side::BUY, MID_PRICE + 5, 300, 100, 100, OrderType::ICEBERG, OTHER, 0, 0, fills);
+    CHECK(report.status == ExecStatus::FILLED);
+    CHECK(report.filled_quantity == 300 && report.leaves_quantity == 0);
+
+    CHECK(sweep(*book, 39, Side::SELL, 2000, OTHER) == 750);
+    CHECK(book->order_count() == 0);
+}
+
+// The live gauges follow a message that only parks a stop
+static void check_gauges_after_stop_entry()
+{
+    auto book = make_check_book();
+    book->add_order(40, Side::BUY, 0, 10, 10, 0, OrderType::STOP_LOSS, BUYER, MID_PRICE + 50);
+
+    TelemetryBook sample;
+    book->sample_telemetry(sample);
+    CHECK(sample.pending_stops == 1);
+    CHECK(sample.indexed_orders == 1);
+    CHECK(sample.pool_allocated == 1);
+}
+
+// Counters survive a snapshot round trip; the gauges are rebuilt from the book
+static void check_snapshot_restores_counters()
+{
+    auto book = make_check_book();
+    Fills fills;
+    book->add_order(50, Side::SELL, MID_PRICE, 300, 300, 0, OrderType::GTC, SELLER, 0, 0, fills);
+    book->add_order(51, Side::BUY, MID_PRICE, 100, 100, 0, OrderType::GTC, BUYER, 0, 0, fills);
+    book->add_order(52, Side::BUY, MID_PRICE, MAX_ORDER_QUANTITY + 1, 1, 0, OrderType::GTC, BUYER, 0, 0, fills);
+
+    string filename = "/tmp/book_check_" + to_string(getpid()) + ".snap";
+    CHECK(book->save_snapshot(filename, 7));
+
+    auto restored = make_unique<OrderBook>(OrderBookConfig{});
+    uint64_t journal_sequence = 0;
+    CHECK(restored->load_snapshot(filename, journal_sequence));
+    remove(filename.c_str());
+    CHECK(journal_sequence == 7);
+
+    TelemetryBook before, after;
+    book->sample_telemetry(before);
+    restored->sample_telemetry(after);
+    CHECK(after.orders == before.orders && after.trades == 1 && after.volume == 100);
+    CHECK(after.risk_rejected == before.risk_rejected);
+    CHECK(after.risk_rejects[static_cast<size_t>(RiskManager::RiskResult::REJECTED_ORDER_SIZE)] == 1);
+    CHECK(after.indexed_orders == 1 && after.ask_levels == 1);
+}
+
+// Limits must land on the tick grid, or they would push a ladder into MAP mode
+static void check_limit_needs_tick_price()
+{
+    auto book = make_check_book();
+    Fills fills;
+    ExecutionReport report = book->add_order(60, Side::BUY, 0, 100, 100, 0, OrderType::GTC, BUYER, 0, 0, fills);
+    CHECK(report.status == ExecStatus::REJECTED_RISK);
+    CHECK(report.risk_result == RiskManager::RiskResult::REJECTED_INVALID_TICK_SIZE);
+    CHECK(book->bid_levels() == 0);
+
+    book->add_order(61, Side::BUY, MID_PRICE, 100, 100, 0, OrderType::GTC, BUYER, 0, 0, fills);
+    report = book->modify_order(61, -5, 100, fills);
+    CHECK(report.status == ExecStatus::REJECTED_RISK);
+    CHECK(book->best_bid() == MID_PRICE);
+}
+
+// covers() against a plain walk of the levels, for limits inside, beyond
+// and off the window on either side, in every ladder layout
+template <Side S>
+static void check_covers_matches_levels(const LadderConfig &config)
+{
+    static constexpr Price CENTER = 200000; // tick 5 anywhere within 2500 of it
+    static constexpr Price TICK = 5;
+    static constexpr Price SPREAD = 128; // 256 ticks of prices, as many as the window has slots
+
+    TickSizeTable ticks;
+    OrderStore store(2048);
+    PriceLadder<S> ladder(config, &ticks);
+    mt19937_64 rng(42);
+    for (int i = 0; i < 1500; i++)
+    {
+        Order *order = store.acquire();
+        order->id = i + 1;
+        order->display = static_cast<int32_t>(1 + rng() % 500);
+        Price price = CENTER + (static_cast<Price>(rng() % (2 * SPREAD)) - SPREAD) * TICK;
+        ladder.get_or_create(price).add_order(store, order);
+    }
+    CHECK(ladder.mode() == config.mode);
+
+    int mismatches = 0;
+    for (int probe = 0; probe < 4000; probe++)
+    {
+        Price limit = CENTER + (static_cast<Price>(rng() % (6 * SPREAD)) - 3 * SPREAD) * TICK;
+        if (rng() % 4 == 0)
+        {
+            limit += static_cast<Price>(rng() % TICK); // off the grid
+        }
+        if (probe % 100 == 0)
+        {
+            limit = static_cast<Price>(probe / 100 % 3) - 1; // -1, 0, 1: far below every level
+        }
+
+        int64_t within = 0;
+        ladder.for_each_level([&](Price price, PriceLevel &level)
+                              {
+                                  if (S == Side::BUY ? price < limit : price > limit)
+                                      return false;
+                                  within += level.visible_quantity;
+                                  return true; });
+
+        // Exactly what the limit reaches, one more, and anything up to all of it
+        for (int64_t quantity : {within, within + 1, 1 + static_cast<int64_t>(rng() % (within + 1))})
+        {
+            if (ladder.covers(limit, quantity) != (within >= quantity))
+            {
+                mismatches++;
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+static void check_covers_ladder_layouts()
+{
+    LadderConfig window; // every slot of a 256-slot window in use
+    window.capacity = 256;
+    LadderConfig units; // one slot per price unit rather than per tick
+    units.tick_indexed = false;
+    units.capacity = 2048;
+    LadderConfig map;
+    map.mode = LadderMode::MAP;
+
+    for (const LadderConfig &config : {window, units, map})
+    {
+        check_covers_matches_levels<Side::BUY>(config);
+        check_covers_matches_levels<Side::SELL>(config);
+    }
+}
+
+// A FOK counts only other owners' quantity; when it fills, the own orders
+// on its way stay resting, and a refilled iceberg can trade again
+static void check_fok_self_trade_and_refill()
+{
+    auto book = make_check_book();
+    Fills fills;
+    book->add_order(70, Side::SELL, MID_PRICE, 100, 100, 0, OrderType::GTC, BUYER, 0, 0, fills);
+    book->add_order(71, Side::SELL, MID_PRICE + 5, 100, 100, 0, OrderType::GTC, SELLER, 0, 0, fills);
+
+    // 200 shown, but only 100 is someone else's: nothing is touched
+    Fills rejected;
+    ExecutionReport report =
+        book->add_order(72, Side::BUY, MID_PRICE + 5, 150, 150, 0, OrderType::FOK, BUYER, 0, 0, rejected);
+    CHECK(report.status == ExecStatus::CANCELLED);
+    CHECK(rejected.trades.empty());
+    CHECK(book->order_count() == 2 && book->best_ask() == MID_PRICE);
+
+    Fills filled;
+    report = book->add_order(73, Side::BUY, MID_PRICE + 5, 100, 100, 0, OrderType::FOK, BUYER, 0, 0, filled);
+    CHECK(report.status == ExecStatus::FILLED);
+    CHECK(filled.trades.size() == 1 && filled.trades[0].sell_id == 71);
+    CHECK(book->order_count() == 1 && book->best_ask() == MID_PRICE);
+
+    // 100 shown behind the own order refills twice inside one FOK
+    book->add_order(74, Side::SELL, MID_PRICE, 300, 100, 100, OrderType::ICEBERG, SELLER, 0, 0, fills);
+    book->add_order(75, Side::SELL, MID_PRICE + 5, 200, 200, 0, OrderType::GTC, OTHER, 0, 0, fills);
+    Fills swept;
+    report = book->add_order(76, Side::BUY, MID_PRICE + 5, 300, 300, 0, OrderType::FOK, BUYER, 0, 0, swept);
+    CHECK(report.status == ExecStatus::FILLED);
+    CHECK(swept.trades.size() == 3);
+    for (const Trade &trade : swept.trades)
+    {
+        CHECK(trade.sell_id == 74 && trade.price == MID_PRICE);
+    }
+    CHECK(book->order_count() == 2 && book->ask_levels() == 2 && book->best_ask() == MID_PRICE);
+}
+
+// An AON_IOC counts like a FOK but cancels the own orders it reaches
+static void check_aon_ioc_cancels_own()
+{
+    auto book = make_check_book();
+    Fills fills;
+    book->add_order(80, Side::SELL, MID_PRICE, 100, 100, 0, OrderType::GTC, BUYER, 0, 0, fills);
+    book->add_order(81, Side::SELL, MID_PRICE, 100, 100, 0, OrderType::GTC, SELLER, 0, 0, fills);
+    book->add_order(82, Side::SELL, MID_PRICE + 5, 100, 100, 0, OrderType::GTC, BUYER, 0, 0, fills);
+
+    Fills filled;
+    ExecutionReport report =
+        book->add_order(83, Side::BUY, MID_PRICE + 5, 100, 100, 0, OrderType::AON_IOC, BUYER, 0, 0, filled);
+    CHECK(report.status == ExecStatus::FILLED);
+    CHECK(filled.trades.size() == 1 && filled.trades[0].sell_id == 81);
+    CHECK(book->order_count() == 1 && book->best_ask() == MID_PRICE + 5);
+}
+
+int main()
+{
+    struct
+    {
+        const char *name;
+        void (*run)();
+    } checks[] = {
+        {"refilled_iceberg_size_down", check_refilled_iceberg_size_down},
+        {"refilled_iceberg_keeps_priority", check_refilled_iceberg_keeps_priority},
+        {"aggressor_iceberg_rests_remainder", check_aggressor_iceberg_rests_remainder},
+        {"aggressor_iceberg_refills", check_aggressor_iceberg_refills},
+        {"gauges_after_stop_entry", check_gauges_after_stop_entry},
+        {"snapshot_restores_counters", check_snapshot_restores_counters},
+        {"limit_needs_tick_price", check_limit_needs_tick_price},
+        {"covers_ladder_layouts", check_covers_ladder_layouts},
+        {"fok_self_trade_and_refill", check_fok_self_trade_and_refill},
+        {"aon_ioc_cancels_own", check_aon_ioc_cancels_own},
+    };
+
+    for (const auto &check : checks)
+    {
+        int before = failures;
+        check.run();
+        cout << (failures == before ? "ok   " : "FAIL ") << check.name << endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+#include "order_book.h"
+#include <cstring>
+#include <unistd.h>
+
+namespace
+{
+    struct SnapshotHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint64_t journal_sequence;
+    };
+
+    // Hot and cold records as they are; queue and owner links are rebuilt on load
+    struct SnapshotOrder
+    {
+        Order hot;
+        OrderCold cold;
+    };
+
+    static_assert(is_trivially_copyable_v<SnapshotOrder>, "orders are snapshotted as raw records");
+
+    constexpr char SNAPSHOT_MAGIC[8] = {'T', 'E', 'S', 'N', 'A', 'P', 'S', 'H'};
+    constexpr uint32_t SNAPSHOT_VERSION = 2;
+}
+
+bool OrderBook::save_snapshot(const string &filename, uint64_t journal_sequence)
+{
+    string temp_name = filename + ".tmp";
+    FILE *file = fopen(temp_name.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+    SnapshotWriter out(file);
+
+    SnapshotHeader header{};
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.record_size = sizeof(SnapshotOrder);
+    header.journal_sequence = journal_sequence;
+    out.put(header);
+
+    out.put(message_time_);
+    out.put(clock_.simulated_time());
+    out.put(last_trade_price_);
+    // Plain copies of the live counters; the gauges are rebuilt on load
+    TelemetryBook counters{};
+    sample_telemetry(counters);
+    out.put(counters);
+    out.put(l2_sequence_);
+    out.put(session_manager_.next_session_id());
+
+    // Resting orders level by level, best first, each queue in time priority
+    auto save_order = [&](const Order *order)
+    {
+        SnapshotOrder record{*order, order_pool_.cold(order)};
+        record.hot.prev = NO_ORDER_SLOT;
+        record.hot.next = NO_ORDER_SLOT;
+        record.cold.owner_prev = NO_ORDER_SLOT;
+        record.cold.owner_next = NO_ORDER_SLOT;
+        out.put(record);
+    };
+    auto save_queue = [&](const OrderQueue &queue)
+    {
+        for (uint32_t slot = queue.head; slot != NO_ORDER_SLOT; slot = order_pool_.at(slot)->next)
+        {
+            save_order(order_pool_.at(slot));
+        }
+    };
+    auto save_level = [&](Price, PriceLevel &level)
+    {
+        save_queue(level.mm_orders);
+        save_queue(level.regular_orders);
+        return true;
+    };
+    uint64_t resting = orders_.size() - stop_manager_.pending_stop_count();
+    out.put(resting);
+    bids_.for_each_level(save_level);
+    asks_.for_each_level(save_level);
+
+    out.put(static_cast<uint64_t>(stop_manager_.pending_stop_count()));
+    stop_manager_.for_each_pending([&](const Order *order, Price)
+                                   { save_order(order); });
+
+    risk_manager_.save_state(out);
+    out.put(header);
+
+    bool ok = out.ok() && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(temp_name.c_str(), filename.c_str()) != 0)
+    {
+        remove(temp_name.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool OrderBook::load_snapshot(const string &filename, uint64_t &journal_sequence)
+{
+    if (!orders_.empty())
+        return false;
+
+    FILE *file = fopen(filename.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+    SnapshotReader in(file);
+
+    SnapshotHeader header{};
+    bool ok = in.get(header) && memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version == SNAPSHOT_VERSION && header.record_size == sizeof(SnapshotOrder);
+
+    int64_t sim_time = 0;
+    uint32_t next_session_id = 1;
+    TelemetryBook counters{};
+    ok = ok && in.get(message_time_) && in.get(sim_time) && in.get(last_trade_price_) && in.get(counters) &&
+         in.get(l2_sequence_) && in.get(next_session_id);
+
+    // Records come in queue order, so appending rebuilds every queue as it was
+    auto load_order = [&]() -> Order *
+    {
+        SnapshotOrder record;
+        if (!in.get(record))
+            return nullptr;
+        Order *order = acquire_order();
+        if (order == nullptr)
+            return nullptr;
+        *order = record.hot;
+        order_pool_.cold(order) = record.cold;
+        index_order(order);
+        return order;
+    };
+
+    uint64_t resting = 0;
+    ok = ok && in.get_count(resting, order_pool_.available_count());
+    if (ok)
+    {
+        orders_.reserve(resting);
+    }
+    for (uint64_t i = 0; ok && i < resting; i++)
+    {
+        Order *order = load_order();
+        ok = order != nullptr;
+        if (ok)
+        {
+            Price price = order_pool_.cold(order).price;
+            PriceLevel &level = order->side == Side::BUY ? bids_.get_or_create(price) : asks_.get_or_create(price);
+            level.add_order(order_pool_, order);
+        }
+    }
+
+    uint64_t stops = 0;
+    ok = ok && in.get_count(stops, order_pool_.available_count());
+    for (uint64_t i = 0; ok && i < stops; i++)
+    {
+        Order *order = load_order();
+        ok = order != nullptr;
+        if (ok)
+        {
+            OrderCold &cold = order_pool_.cold(order);
+            cold.stop_slot = stop_manager_.add_stop_order(order, cold.stop_price);
+        }
+    }
+
+    SnapshotHeader trailer{};
+    ok = ok && risk_manager_.load_state(in) && in.get(trailer) && memcmp(&trailer, &header, sizeof(header)) == 0;
+    fclose(file);
+    if (!ok)
+        return false;
+
+    restore_counters(counters);
+    refresh_gauges();
+    clock_.set_simulated_time(sim_time);
+    session_manager_.set_next_session_id(next_session_id);
+    journal_sequence = header.journal_sequence;
+    return true;
+}
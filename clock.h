@@ -0,0 +1,169 @@
+#pragma once
+#include "types.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#include <cpuid.h>
+#define ENGINE_HAS_TSC 1
+#endif
+
+// Raw time-stamp counter, converted to steady_clock nanoseconds with a
+// fixed-point multiplier calibrated once per process. Without an invariant
+// TSC it falls back to steady_clock.
+class TscClock
+{
+private:
+    struct Calibration
+    {
+        bool use_tsc;
+        uint64_t base_ticks;
+        int64_t base_ns;
+        uint64_t mult; // ns per tick, 32.32 fixed point
+    };
+
+    static bool has_invariant_tsc()
+    {
+#ifdef ENGINE_HAS_TSC
+        unsigned eax, ebx, ecx, edx;
+        if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) && eax >= 0x80000007 &&
+            __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+        {
+            return (edx >> 8) & 1;
+        }
+#endif
+        return false;
+    }
+
+    static int64_t steady_ns()
+    {
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    static Calibration calibrate()
+    {
+        Calibration cal{false, 0, steady_ns(), 0};
+        if (!has_invariant_tsc())
+            return cal;
+
+        uint64_t t0 = ticks();
+        int64_t n0 = steady_ns();
+        int64_t n1 = n0;
+        while (n1 - n0 < 10000000)
+        {
+            n1 = steady_ns();
+        }
+        uint64_t t1 = ticks();
+        if (t1 <= t0)
+            return cal;
+
+        cal.use_tsc = true;
+        cal.base_ticks = t1;
+        cal.base_ns = n1;
+        cal.mult = static_cast<uint64_t>((static_cast<unsigned __int128>(n1 - n0) << 32) / (t1 - t0));
+        return cal;
+    }
+
+    static const Calibration &calibration()
+    {
+        static const Calibration cal = calibrate();
+        return cal;
+    }
+
+public:
+    // Serialized read: earlier instructions retire before the counter is sampled
+    static uint64_t ticks()
+    {
+#ifdef ENGINE_HAS_TSC
+        _mm_lfence();
+        uint64_t t = __rdtsc();
+        _mm_lfence();
+        return t;
+#else
+        return static_cast<uint64_t>(steady_ns());
+#endif
+    }
+
+    static int64_t ticks_to_ns(uint64_t delta)
+    {
+        const Calibration &cal = calibration();
+        if (!cal.use_tsc)
+            return static_cast<int64_t>(delta);
+        return static_cast<int64_t>((static_cast<unsigned __int128>(delta) * cal.mult) >> 32);
+    }
+
+    static int64_t now_ns()
+    {
+        const Calibration &cal = calibration();
+        if (!cal.use_tsc)
+            return steady_ns();
+        return cal.base_ns + ticks_to_ns(ticks() - cal.base_ticks);
+    }
+};
+
+enum class ClockSource
+{
+    TSC,      // calibrated time-stamp counter
+    GATEWAY,  // timestamp supplied with each inbound message
+    SIMULATED // deterministic time for replay, step_ns per inbound message
+};
+
+struct ClockConfig
+{
+    ClockSource source = ClockSource::TSC;
+    int64_t start_ns = 0;   // SIMULATED only
+    int64_t step_ns = 1000; // SIMULATED only
+};
+
+// The book's single time source, read once per inbound message; that value
+// stamps the order, drives the risk checks and stamps every trade it causes
+class EngineClock
+{
+private:
+    ClockSource source_;
+    int64_t sim_ns_;
+    int64_t step_ns_;
+    int64_t gateway_ns_;
+    int64_t pinned_ns_;
+    bool pinned_;
+
+public:
+    EngineClock(const ClockConfig &config = ClockConfig{})
+        : source_(config.source), sim_ns_(config.start_ns), step_ns_(config.step_ns), gateway_ns_(0),
+          pinned_ns_(0), pinned_(false) {}
+
+    ClockSource source() const { return source_; }
+
+    int64_t message_time()
+    {
+        if (pinned_)
+        {
+            pinned_ = false;
+            sim_ns_ = source_ == ClockSource::SIMULATED ? pinned_ns_ : sim_ns_;
+            return pinned_ns_;
+        }
+        switch (source_)
+        {
+        case ClockSource::GATEWAY:
+            return gateway_ns_;
+        case ClockSource::SIMULATED:
+            sim_ns_ += step_ns_;
+            return sim_ns_;
+        default:
+            return TscClock::now_ns();
+        }
+    }
+
+    // GATEWAY: the timestamp of the next message
+    void set_gateway_time(int64_t ns) { gateway_ns_ = ns; }
+
+    // SIMULATED: jump to ns, the next message is stamped ns + step
+    void set_simulated_time(int64_t ns) { sim_ns_ = ns; }
+    int64_t simulated_time() const { return sim_ns_; }
+
+    // Any source: the next message is stamped exactly ns, so a journaled
+    // message replays at its original time; SIMULATED then steps on from ns
+    void pin_next(int64_t ns)
+    {
+        pinned_ns_ = ns;
+        pinned_ = true;
+    }
+};
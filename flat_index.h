@@ -0,0 +1,216 @@
+#pragma once
+#include "types.h"
+#include <limits>
+
+// Open-addressing hash index for integer keys: order ids, trader ids. The
+// entries sit in one flat array probed linearly from a multiply-shift hash,
+// which spreads monotonic and strided ids alike, and the table stays at most
+// half full, so a hit is usually the first entry read. Erase shifts the rest
+// of the probe run back instead of leaving a tombstone, so probe lengths
+// depend only on what is live. The largest key value marks a free entry and
+// is kept aside in its own slot.
+//
+// Entries move: a pointer from find() or a reference from operator[] stays
+// valid until the next insert or erase.
+template <typename Key, typename Value>
+class FlatIndex
+{
+    static_assert(is_integral_v<Key> && is_unsigned_v<Key>, "FlatIndex keys are unsigned integers");
+
+private:
+    struct Entry
+    {
+        Key key;
+        Value value;
+    };
+
+    static constexpr Key FREE = numeric_limits<Key>::max();
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    vector<Entry> entries_;
+    size_t mask_;
+    int shift_;
+    size_t size_; // including the aside entry
+    bool has_free_key_;
+    Value free_key_value_;
+
+    size_t home(Key key) const
+    {
+        return static_cast<size_t>((static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull) >> shift_);
+    }
+
+    // Index of key's entry, or of the free entry ending its probe run
+    size_t probe(Key key) const
+    {
+        size_t i = home(key);
+        while (entries_[i].key != key && entries_[i].key != FREE)
+        {
+            i = (i + 1) & mask_;
+        }
+        return i;
+    }
+
+    void rehash(size_t capacity)
+    {
+        vector<Entry> old;
+        old.swap(entries_);
+        entries_.assign(capacity, Entry{FREE, Value{}});
+        mask_ = capacity - 1;
+        shift_ = 64 - __builtin_ctzll(capacity);
+        for (Entry &entry : old)
+        {
+            if (entry.key != FREE)
+            {
+                entries_[probe(entry.key)] = std::move(entry);
+            }
+        }
+    }
+
+    static size_t capacity_for(size_t count)
+    {
+        size_t capacity = MIN_CAPACITY;
+        while (capacity / 2 < count)
+        {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+public:
+    FlatIndex() : mask_(0), shift_(64), size_(0), has_free_key_(false), free_key_value_{}
+    {
+        rehash(MIN_CAPACITY);
+    }
+
+    Value *find(Key key)
+    {
+        if (key == FREE)
+            return has_free_key_ ? &free_key_value_ : nullptr;
+        Entry &entry = entries_[probe(key)];
+        return entry.key == key ? &entry.value : nullptr;
+    }
+
+    const Value *find(Key key) const
+    {
+        return const_cast<FlatIndex *>(this)->find(key);
+    }
+
+    bool contains(Key key) const { return find(key) != nullptr; }
+
+    // Inserts a value-initialized entry when key is absent
+    Value &operator[](Key key)
+    {
+        if (key == FREE)
+        {
+            if (!has_free_key_)
+            {
+                has_free_key_ = true;
+                free_key_value_ = Value{};
+                size_++;
+            }
+            return free_key_value_;
+        }
+
+        size_t i = probe(key);
+        if (entries_[i].key == key)
+            return entries_[i].value;
+
+        if ((size_ + 1) * 2 > entries_.size())
+        {
+            rehash(entries_.size() * 2);
+            i = probe(key);
+        }
+        entries_[i].key = key;
+        entries_[i].value = Value{};
+        size_++;
+        return entries_[i].value;
+    }
+
+    bool erase(Key key)
+    {
+        if (key == FREE)
+        {
+            if (!has_free_key_)
+                return false;
+            has_free_key_ = false;
+            size_--;
+            return true;
+        }
+
+        size_t hole = probe(key);
+        if (entries_[hole].key != key)
+            return false;
+
+        // Pull back each later entry of the run that may sit in the hole:
+        // one whose home is no further from it than the hole is
+        for (size_t i = (hole + 1) & mask_; entries_[i].key != FREE; i = (i + 1) & mask_)
+        {
+            if (((i - home(entries_[i].key)) & mask_) >= ((i - hole) & mask_))
+            {
+                entries_[hole] = std::move(entries_[i]);
+                hole = i;
+            }
+        }
+        entries_[hole].key = FREE;
+        entries_[hole].value = Value{};
+        size_--;
+        return true;
+    }
+
+    // Sized so count entries fit without a rehash
+    void reserve(size_t count)
+    {
+        size_t capacity = capacity_for(count);
+        if (capacity > entries_.size())
+        {
+            rehash(capacity);
+        }
+    }
+
+    void clear()
+    {
+        for (Entry &entry : entries_)
+        {
+            entry = Entry{FREE, Value{}};
+        }
+        has_free_key_ = false;
+        size_ = 0;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return entries_.size(); }
+
+    // One pass over the flat array, in table order, not key order
+    template <typename Fn>
+    void for_each(Fn &&fn)
+    {
+        for (Entry &entry : entries_)
+        {
+            if (entry.key != FREE)
+            {
+                fn(entry.key, entry.value);
+            }
+        }
+        if (has_free_key_)
+        {
+            fn(FREE, free_key_value_);
+        }
+    }
+
+    template <typename Fn>
+    void for_each(Fn &&fn) const
+    {
+        for (const Entry &entry : entries_)
+        {
+            if (entry.key != FREE)
+            {
+                fn(entry.key, entry.value);
+            }
+        }
+        if (has_free_key_)
+        {
+            fn(FREE, free_key_value_);
+        }
+    }
+};
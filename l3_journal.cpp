@@ -0,0 +1,100 @@
+#include "l3_journal.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+L3JournalWriter::L3JournalWriter(L3Journal &journal, int fd, int core)
+    : journal_(journal), fd_(fd), owns_fd_(false), core_(core), running_(false), events_written_(0), failed_(false)
+{
+}
+
+L3JournalWriter::L3JournalWriter(L3Journal &journal, const string &filename, int core)
+    : journal_(journal), fd_(::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)), owns_fd_(true),
+      core_(core), running_(false), events_written_(0), failed_(false)
+{
+}
+
+L3JournalWriter::~L3JournalWriter()
+{
+    stop();
+    if (owns_fd_ && fd_ >= 0)
+    {
+        ::close(fd_);
+    }
+}
+
+void L3JournalWriter::start()
+{
+    if (fd_ < 0 || worker_.joinable())
+        return;
+
+    running_.store(true, memory_order_release);
+    worker_ = thread([this]
+                     { run(); });
+}
+
+void L3JournalWriter::stop()
+{
+    if (!worker_.joinable())
+        return;
+
+    running_.store(false, memory_order_release);
+    worker_.join();
+}
+
+bool L3JournalWriter::write_all(const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = ::write(fd_, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+void L3JournalWriter::run()
+{
+    if (core_ >= 0)
+    {
+        pin_thread_to_core(core_);
+    }
+
+    unsigned idle_spins = 0;
+    uint64_t written = 0;
+    while (true)
+    {
+        const L3Event *first = nullptr;
+        size_t count = journal_.peek(first);
+        if (count == 0)
+        {
+            if (!running_.load(memory_order_acquire) && journal_.empty())
+                break;
+            events_written_.store(written, memory_order_relaxed);
+            idle_backoff(idle_spins);
+            continue;
+        }
+        idle_spins = 0;
+
+        // A failed descriptor still drains, so the book's ring never stays full
+        if (!failed_.load(memory_order_relaxed))
+        {
+            if (write_all(reinterpret_cast<const char *>(first), count * sizeof(L3Event)))
+            {
+                written += count;
+            }
+            else
+            {
+                failed_.store(true, memory_order_relaxed);
+            }
+        }
+        journal_.consume(count);
+    }
+    events_written_.store(written, memory_order_relaxed);
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include "types.h"
+#include "spsc_queue.h"
+
+enum class L3EventType : uint8_t
+{
+    ADD,          // order rests on the book
+    MODIFY,       // iceberg refill: new displayed slice, back of the queue
+    EXECUTE,      // resting order traded against contra_id
+    CANCEL,       // resting order left the book without trading
+    STOP_TRIGGER, // pending stop became a market order
+    REDUCE,       // modify size-down in place, keeps its queue position
+};
+
+enum class L3CancelReason : uint8_t
+{
+    NONE,
+    USER,       // cancel_order
+    SELF_TRADE, // removed by its own owner's aggressive order
+    REPLACED,   // modify to a new price or a larger size, re-added as a new ADD
+};
+
+// Fixed 64-byte little-endian record, one cache line. Files and sockets
+// carry these back to back; a gap in sequence means the ring was full.
+struct alignas(64) L3Event
+{
+    uint64_t sequence;
+    int64_t timestamp; // book time of the inbound message that caused it
+    OrderId order_id;
+    OrderId contra_id; // aggressor, EXECUTE only
+    Price price;
+    int32_t quantity; // executed (EXECUTE), displayed (ADD, MODIFY) or removed (CANCEL, REDUCE)
+    int32_t leaves;   // displayed quantity still resting afterwards
+    uint32_t owner;
+    L3EventType type;
+    Side side;
+    L3CancelReason reason;
+    uint8_t reserved[9];
+};
+
+static_assert(sizeof(L3Event) == 64, "L3 event encoding is one cache line");
+static_assert(is_trivially_copyable_v<L3Event>, "L3 events are written straight from the ring");
+
+// Pre-allocated SPSC ring between the book (producer) and a drain thread.
+// record() never blocks: with the ring full the event is dropped but still
+// takes its sequence number, so consumers see exactly where the gap is.
+class L3Journal
+{
+private:
+    SpscQueue<L3Event> ring_;
+    uint64_t next_sequence_;
+    atomic<uint64_t> dropped_;
+
+public:
+    explicit L3Journal(size_t capacity = 65536) : ring_(capacity), next_sequence_(1), dropped_(0) {}
+
+    L3Journal(const L3Journal &) = delete;
+    L3Journal &operator=(const L3Journal &) = delete;
+
+    // Producer side, from the book's thread only
+    void record(L3Event &event)
+    {
+        event.sequence = next_sequence_++;
+        if (!ring_.try_push(event))
+        {
+            dropped_.store(dropped_.load(memory_order_relaxed) + 1, memory_order_relaxed);
+        }
+    }
+
+    uint64_t last_sequence() const { return next_sequence_ - 1; }
+    uint64_t dropped() const { return dropped_.load(memory_order_relaxed); }
+
+    // Consumer side, see SpscQueue::peek
+    size_t peek(const L3Event *&first) { return ring_.peek(first); }
+    void consume(size_t count) { ring_.consume(count); }
+    bool empty() const { return ring_.empty(); }
+};
+
+// Drains a journal on its own thread, writing events from the ring memory
+// straight to a file descriptor (file, pipe or socket)
+class L3JournalWriter
+{
+private:
+    L3Journal &journal_;
+    int fd_;
+    bool owns_fd_;
+    int core_;
+    thread worker_;
+    atomic<bool> running_;
+    atomic<uint64_t> events_written_;
+    atomic<bool> failed_;
+
+    void run();
+    bool write_all(const char *data, size_t size);
+
+public:
+    // core < 0 leaves the drain thread unpinned
+    L3JournalWriter(L3Journal &journal, int fd, int core = -1);
+    L3JournalWriter(L3Journal &journal, const string &filename, int core = -1);
+    ~L3JournalWriter();
+
+    L3JournalWriter(const L3JournalWriter &) = delete;
+    L3JournalWriter &operator=(const L3JournalWriter &) = delete;
+
+    bool is_open() const { return fd_ >= 0; }
+    void start();
+    void stop(); // writes whatever is still queued, then joins
+
+    uint64_t events_written() const { return events_written_.load(memory_order_relaxed); }
+    bool failed() const { return failed_.load(memory_order_relaxed); }
+};
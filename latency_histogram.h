@@ -0,0 +1,127 @@
+#pragma once
+#include "types.h"
+#include "clock.h"
+#include <cmath>
+
+// Fixed-memory log-linear histogram of nanosecond latencies, HDR style: each
+// power of two is split into 32 linear sub-buckets, so any recorded value is
+// reported within ~3%. Recording is a couple of bit ops and an increment;
+// histograms from different threads are combined with merge().
+class LatencyHistogram
+{
+public:
+    static constexpr int SUB_BITS = 5;
+    static constexpr size_t SUB_COUNT = size_t(1) << SUB_BITS;
+    static constexpr size_t BUCKET_COUNT = (64 - SUB_BITS) * SUB_COUNT;
+
+private:
+    uint64_t counts_[BUCKET_COUNT];
+    uint64_t total_;
+    int64_t min_;
+    int64_t max_;
+    uint64_t sum_;
+
+    static size_t bucket_of(uint64_t value)
+    {
+        if (value < 2 * SUB_COUNT)
+            return static_cast<size_t>(value);
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - SUB_BITS;
+        return static_cast<size_t>(shift) * SUB_COUNT + static_cast<size_t>(value >> shift);
+    }
+
+    // Highest value that lands in bucket idx
+    static int64_t bucket_upper(size_t idx)
+    {
+        if (idx < 2 * SUB_COUNT)
+            return static_cast<int64_t>(idx);
+        size_t shift = idx / SUB_COUNT - 1;
+        uint64_t mantissa = idx - shift * SUB_COUNT;
+        return static_cast<int64_t>(((mantissa + 1) << shift) - 1);
+    }
+
+public:
+    LatencyHistogram() { reset(); }
+
+    void reset()
+    {
+        std::fill(std::begin(counts_), std::end(counts_), 0);
+        total_ = 0;
+        min_ = LLONG_MAX;
+        max_ = 0;
+        sum_ = 0;
+    }
+
+    void record(int64_t ns)
+    {
+        uint64_t value = ns > 0 ? static_cast<uint64_t>(ns) : 0;
+        counts_[bucket_of(value)]++;
+        total_++;
+        sum_ += value;
+        min_ = std::min<int64_t>(min_, value);
+        max_ = std::max<int64_t>(max_, value);
+    }
+
+    void merge(const LatencyHistogram &other)
+    {
+        for (size_t i = 0; i < BUCKET_COUNT; i++)
+        {
+            counts_[i] += other.counts_[i];
+        }
+        total_ += other.total_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    uint64_t count() const { return total_; }
+    int64_t min() const { return total_ ? min_ : 0; }
+    int64_t max() const { return max_; }
+    double mean() const { return total_ ? static_cast<double>(sum_) / total_ : 0.0; }
+
+    // Smallest bucket bound that covers fraction p (0..1) of the samples
+    int64_t percentile(double p) const
+    {
+        if (total_ == 0)
+            return 0;
+
+        uint64_t target = static_cast<uint64_t>(ceil(p * total_));
+        target = std::max<uint64_t>(1, std::min(target, total_));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; i++)
+        {
+            seen += counts_[i];
+            if (seen >= target)
+                return std::min(bucket_upper(i), max_);
+        }
+        return max_;
+    }
+};
+
+// Optional per-stage timing inside the book, compiled in with
+// -DENGINE_STAGE_TIMERS (make STAGE_TIMERS=1). Stages are inclusive: pool
+// releases inside the match loop count towards both match and pool.
+struct StageTimers
+{
+    LatencyHistogram screen; // screen_order: size range, static limits, tick rounding
+    LatencyHistogram risk;   // RiskManager::check_order, check_modify and check_quotes
+    LatencyHistogram match;  // crossing the book, any order type
+    LatencyHistogram stops;  // process_triggered_stops, including the triggered stops' fills
+    LatencyHistogram pool;   // order store acquire and release
+};
+
+#ifdef ENGINE_STAGE_TIMERS
+class ScopedStageTimer
+{
+private:
+    LatencyHistogram &histogram_;
+    uint64_t start_;
+
+public:
+    explicit ScopedStageTimer(LatencyHistogram &histogram) : histogram_(histogram), start_(TscClock::ticks()) {}
+    ~ScopedStageTimer() { histogram_.record(TscClock::ticks_to_ns(TscClock::ticks() - start_)); }
+};
+#define STAGE_TIMER(histogram) ScopedStageTimer stage_timer_(histogram)
+#else
+#define STAGE_TIMER(histogram) ((void)0)
+#endif
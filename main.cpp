@@ -1,5 +1,10 @@
 #include "order_book.h"
 #include "market_data.h"
+#include "matching_engine.h"
+#include "open_loop.h"
+#include "persistence.h"
+#include "pipeline.h"
+#include "telemetry.h"
 
 void setup_demo_risk_limits(OrderBook &book)
 {
@@ -24,10 +29,30 @@ void setup_demo_risk_limits(OrderBook &book)
     risk_mgr.mark_to_market(100000);
 }
 
-void generate_test_data(const string &filename, size_t count)
+bool is_binary_filename(const string &filename)
 {
+    return filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".bin") == 0;
+}
+
+void generate_test_data(const string &filename, size_t count, const GeneratorConfig &config = GeneratorConfig{})
+{
+    auto start_time = high_resolution_clock::now();
+    if (is_binary_filename(filename))
+    {
+        // Independent seeded streams in parallel, straight into the replay file
+        if (generate_replay_file(filename, count, config) < 0)
+        {
+            cerr << "Error: Cannot write replay file " << filename << endl;
+            return;
+        }
+        auto total_time = duration_cast<milliseconds>(high_resolution_clock::now() - start_time).count();
+        size_t streams = (count + config.slice_orders - 1) / config.slice_orders;
+        cout << " Generated " << count << " orders in " << streams << " stream(s) of " << config.slice_orders
+             << ", seed " << config.seed << ", " << total_time << " ms" << endl;
+        return;
+    }
 
-    MarketDataGenerator generator;
+    MarketDataGenerator generator(config.seed);
     ofstream file(filename);
     file << "order_id,side,price,quantity,type,disp,display_size,owner,stop_price,session_id,ip_address\n";
 
@@ -38,105 +63,205 @@ void generate_test_data(const string &filename, size_t count)
             generator.update_market_dynamics();
         }
 
-        generator.generate_realistic_order(file, i, count);
+        MarketDataGenerator::write_csv_order(file, generator.generate_realistic_order(i, count));
     }
 
     generator.print_market_state();
 }
 
-void run_benchmark(const string &filename)
+// ENGINE_TELEMETRY=<shm name> publishes the books' counters while the run
+// lasts; read them from another shell with ./matching_engine telemetry <name>
+unique_ptr<TelemetrySampler> start_telemetry(const vector<const OrderBook *> &books)
 {
-    OrderBook book;
-    setup_demo_risk_limits(book);
+    const char *name = getenv("ENGINE_TELEMETRY");
+    if (name == nullptr || *name == '\0')
+        return nullptr;
 
-    ifstream file(filename);
-    if (!file.is_open())
+    auto sampler = make_unique<TelemetrySampler>(name);
+    for (const OrderBook *book : books)
     {
-        cerr << "Error: Cannot open file " << filename << endl;
-        return;
+        if (!sampler->add_book(*book))
+        {
+            cerr << "Warning: telemetry covers the first " << TelemetrySegment::MAX_BOOKS << " books only" << endl;
+            break;
+        }
     }
+    if (!sampler->start())
+    {
+        cerr << "Warning: Cannot create telemetry segment " << name << endl;
+        return nullptr;
+    }
+    return sampler;
+}
 
-    string line;
-    getline(file, line);
+void print_telemetry(const string &name, int64_t interval_ms, size_t samples)
+{
+    for (size_t i = 0; i < samples; i++)
+    {
+        if (i > 0)
+        {
+            this_thread::sleep_for(milliseconds(interval_ms));
+        }
+        TelemetrySegment segment;
+        if (!read_telemetry(name, segment))
+        {
+            cerr << "Error: No telemetry segment " << name << endl;
+            return;
+        }
 
-    vector<int64_t> latencies;
-    latencies.reserve(1000000);
-    size_t order_count = 0;
-    size_t trade_count = 0;
-    size_t rejected_count = 0;
+        cout << "sample " << segment.samples << ", " << segment.book_count << " book(s)" << endl;
+        for (uint32_t b = 0; b < segment.book_count; b++)
+        {
+            const TelemetryBook &book = segment.books[b];
+            cout << "  book " << b << ": orders " << book.orders << ", trades " << book.trades
+                 << ", volume " << book.volume << ", cancelled " << book.cancelled
+                 << ", modified " << book.modified << ", stops " << book.stops_triggered << endl;
+            cout << "    risk rejected " << book.risk_rejected;
+            for (size_t r = 1; r < RiskManager::RESULT_COUNT; r++)
+            {
+                if (book.risk_rejects[r] > 0)
+                {
+                    cout << ", " << RiskManager::result_name(static_cast<RiskManager::RiskResult>(r)) << " "
+                         << book.risk_rejects[r];
+                }
+            }
+            cout << endl;
+            cout << "    pool " << book.pool_allocated << "/" << book.pool_capacity << ", levels "
+                 << book.bid_levels << " bid " << book.ask_levels << " ask, indexed " << book.indexed_orders
+                 << ", pending stops " << book.pending_stops << endl;
+        }
+    }
+}
 
-    auto start_time = high_resolution_clock::now();
+static void print_latency_line(const char *label, const LatencyHistogram &histogram)
+{
+    cout << "  • " << left << setw(10) << label << right << fixed << setprecision(2)
+         << " n=" << histogram.count()
+         << "  p50=" << histogram.percentile(0.50) / 1000.0
+         << "  p99=" << histogram.percentile(0.99) / 1000.0
+         << "  p99.9=" << histogram.percentile(0.999) / 1000.0
+         << "  max=" << histogram.max() / 1000.0 << endl;
+}
 
-    while (getline(file, line))
-    {
-        auto order_start = high_resolution_clock::now();
+void run_benchmark(const string &filename, ClockSource clock = ClockSource::TSC, const string &l3_filename = "")
+{
+    OrderBookConfig config;
+    config.clock.source = clock;
+    OrderBook book(config);
+    setup_demo_risk_limits(book);
+    auto telemetry = start_telemetry({&book});
 
-        stringstream ss(line);
-        string token;
-        vector<string> tokens;
-        while (getline(ss, token, ','))
+    // Optional order-by-order feed, drained to a file by its own thread
+    unique_ptr<L3Journal> l3_journal;
+    unique_ptr<L3JournalWriter> l3_writer;
+    if (!l3_filename.empty())
+    {
+        l3_journal = make_unique<L3Journal>(1 << 20);
+        l3_writer = make_unique<L3JournalWriter>(*l3_journal, l3_filename);
+        if (!l3_writer->is_open())
         {
-            tokens.push_back(token);
+            cerr << "Error: Cannot create L3 journal " << l3_filename << endl;
+            return;
         }
+        book.set_l3_journal(l3_journal.get());
+        l3_writer->start();
+    }
 
-        if (tokens.size() != 11)
-            continue;
+    bool binary = ReplayFile::is_replay_file(filename);
+    unique_ptr<ReplayFile> replay;
+    ifstream file;
+    if (binary)
+    {
+        replay = make_unique<ReplayFile>(filename);
+        if (!replay->is_open())
+        {
+            cerr << "Error: Cannot map replay file " << filename << endl;
+            return;
+        }
+    }
+    else
+    {
+        file.open(filename);
+        if (!file.is_open())
+        {
+            cerr << "Error: Cannot open file " << filename << endl;
+            return;
+        }
+    }
 
-        OrderId id = stoull(tokens[0]);
-        Side side = (tokens[1] == "BUY") ? Side::BUY : Side::SELL;
-        Price price = stoll(tokens[2]);
-        Quantity qty = stoll(tokens[3]);
+    // Fixed memory however long the run; one histogram per order type
+    constexpr size_t TYPE_COUNT = static_cast<size_t>(OrderType::AON_IOC) + 1;
+    vector<LatencyHistogram> by_type(TYPE_COUNT);
+    LatencyHistogram decode_latency;
+    size_t order_count = 0;
+    size_t trade_count = 0;
+    size_t rejected_count = 0;
+    TradeChecksum checksum;
 
-        OrderType type;
-        if (tokens[4] == "GTC")
-            type = OrderType::GTC;
-        else if (tokens[4] == "IOC")
-            type = OrderType::IOC;
-        else if (tokens[4] == "ICEBERG")
-            type = OrderType::ICEBERG;
-        else if (tokens[4] == "MARKET")
-            type = OrderType::MARKET;
-        else if (tokens[4] == "STOP_LOSS")
-            type = OrderType::STOP_LOSS;
-        else
-            type = OrderType::GTC;
+    // Only the engine call is timed, decoding stays outside the latency sample
+    auto process = [&](const ReplayOrder &order)
+    {
+        uint64_t order_start = TscClock::ticks();
 
-        Quantity disp = stoll(tokens[5]);
-        Quantity display_size = stoll(tokens[6]);
-        uint32_t owner = stoul(tokens[7]);
-        Price stop_price = stoll(tokens[8]);
-        uint32_t session_id = stoul(tokens[9]);
-        string ip_address = tokens[10];
+        ExecutionReport report = replay_order(book, order, checksum);
 
-        auto trades = book.add_order(id, side, price, qty, disp, display_size, type, owner, stop_price, session_id);
+        size_t type = min<size_t>(order.type, TYPE_COUNT - 1);
+        by_type[type].record(TscClock::ticks_to_ns(TscClock::ticks() - order_start));
 
-        if (trades.empty() && (type == OrderType::GTC || type == OrderType::ICEBERG))
+        if (report.status == ExecStatus::REJECTED_RISK || report.status == ExecStatus::REJECTED_NO_MEMORY)
         {
             rejected_count++;
         }
 
-        auto order_end = high_resolution_clock::now();
-        auto latency = duration_cast<nanoseconds>(order_end - order_start).count();
-        latencies.push_back(latency);
-
         order_count++;
-        trade_count += trades.size();
+        trade_count += report.trade_count;
 
         if (order_count % 1000 == 0)
         {
             Price current_price = book.best_bid() > 0 ? (book.best_bid() + book.best_ask()) / 2 : 100000;
             book.get_risk_manager().mark_to_market(current_price);
         }
+    };
+
+    auto start_time = high_resolution_clock::now();
+
+    if (binary)
+    {
+        for (const ReplayOrder &order : *replay)
+        {
+            process(order);
+        }
+    }
+    else
+    {
+        string line;
+        getline(file, line);
+
+        ReplayOrder order;
+        while (getline(file, line))
+        {
+            uint64_t decode_start = TscClock::ticks();
+            bool parsed = parse_csv_order(line, order);
+            decode_latency.record(TscClock::ticks_to_ns(TscClock::ticks() - decode_start));
+            if (parsed)
+            {
+                process(order);
+            }
+        }
     }
 
     auto end_time = high_resolution_clock::now();
     auto total_time = duration_cast<milliseconds>(end_time - start_time).count();
+    if (l3_writer)
+    {
+        l3_writer->stop();
+    }
 
-    sort(latencies.begin(), latencies.end());
-    size_t p50_idx = latencies.size() * 0.50;
-    size_t p95_idx = latencies.size() * 0.95;
-    size_t p99_idx = latencies.size() * 0.99;
-    double mean_latency = accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
+    LatencyHistogram latency;
+    for (const LatencyHistogram &histogram : by_type)
+    {
+        latency.merge(histogram);
+    }
 
     cout << "\n╔══════════════════════════════════════╗" << endl;
     cout << "║      PERFORMANCE REPORT              ║" << endl;
@@ -150,14 +275,67 @@ void run_benchmark(const string &filename)
     cout << "  • Total time: " << total_time << " ms" << endl;
     cout << "  • Throughput: " << (order_count * 1000 / max<long long>(total_time, 1LL))
          << " orders/sec" << endl;
+    cout << "  • Trade checksum: " << hex << setw(16) << setfill('0') << checksum.value()
+         << dec << setfill(' ') << endl;
+    if (l3_writer)
+    {
+        cout << "  • L3 events: " << l3_journal->last_sequence() << " (" << l3_writer->events_written()
+             << " written to " << l3_filename << ", " << l3_journal->dropped() << " dropped)" << endl;
+    }
 
     cout << "\n⚡ Latency Analysis (per order):" << endl;
-    cout << "  • Mean: " << fixed << setprecision(1) << mean_latency / 1000.0 << " μs" << endl;
-    cout << "  • P50:  " << latencies[p50_idx] / 1000.0 << " μs" << endl;
-    cout << "  • P95:  " << latencies[p95_idx] / 1000.0 << " μs" << endl;
-    cout << "  • P99:  " << latencies[p99_idx] / 1000.0 << " μs" << endl;
-    cout << "  • Min:  " << latencies.front() / 1000.0 << " μs" << endl;
-    cout << "  • Max:  " << latencies.back() / 1000.0 << " μs" << endl;
+    cout << "  • Mean: " << fixed << setprecision(1) << latency.mean() / 1000.0 << " μs" << endl;
+    cout << "  • P50:  " << latency.percentile(0.50) / 1000.0 << " μs" << endl;
+    cout << "  • P95:  " << latency.percentile(0.95) / 1000.0 << " μs" << endl;
+    cout << "  • P99:  " << latency.percentile(0.99) / 1000.0 << " μs" << endl;
+    cout << "  • Min:  " << latency.min() / 1000.0 << " μs" << endl;
+    cout << "  • Max:  " << latency.max() / 1000.0 << " μs" << endl;
+
+    cout << "\n By order type (μs):" << endl;
+    for (size_t type = 0; type < TYPE_COUNT; type++)
+    {
+        print_latency_line(order_type_name(static_cast<OrderType>(type)), by_type[type]);
+    }
+
+    cout << "\n By stage (μs):" << endl;
+    if (decode_latency.count() > 0)
+    {
+        print_latency_line("decode", decode_latency);
+    }
+    if (const StageTimers *stages = book.stage_timers())
+    {
+        print_latency_line("screen", stages->screen);
+        print_latency_line("risk", stages->risk);
+        print_latency_line("match", stages->match);
+        print_latency_line("stops", stages->stops);
+        print_latency_line("pool", stages->pool);
+    }
+    else
+    {
+        cout << "  (engine stages not timed, rebuild with make STAGE_TIMERS=1)" << endl;
+    }
+
+    cout << "\n Closing depth (top 5, price x qty / orders):" << endl;
+    vector<L2Level> bid_depth, ask_depth;
+    book.get_depth(Side::BUY, 5, bid_depth);
+    book.get_depth(Side::SELL, 5, ask_depth);
+    for (size_t i = 0; i < max(bid_depth.size(), ask_depth.size()); i++)
+    {
+        auto print_level = [](const vector<L2Level> &levels, size_t i)
+        {
+            ostringstream text;
+            if (i < levels.size())
+            {
+                text << levels[i].price << " x " << levels[i].quantity << " / " << levels[i].order_count;
+            }
+            cout << setw(28) << text.str();
+        };
+        cout << "  ";
+        print_level(bid_depth, i);
+        cout << "  |";
+        print_level(ask_depth, i);
+        cout << endl;
+    }
 
     cout << "\n Memory Pool Performance:" << endl;
     book.print_pool_stats();
@@ -166,6 +344,253 @@ void run_benchmark(const string &filename)
     book.print_stats();
 }
 
+void run_pipeline_benchmark(const string &filename, ClockSource clock = ClockSource::TSC)
+{
+    OrderBookConfig config;
+    config.clock.source = clock;
+    OrderBook book(config);
+    setup_demo_risk_limits(book);
+    auto telemetry = start_telemetry({&book});
+
+    ReplayPipeline pipeline(book);
+    ReplayPipeline::Result result;
+    if (!pipeline.run(filename, result))
+    {
+        cerr << "Error: Cannot open file " << filename << endl;
+        return;
+    }
+
+    LatencyHistogram latency;
+    for (const LatencyHistogram &histogram : result.by_type)
+    {
+        latency.merge(histogram);
+    }
+
+    cout << "\n╔══════════════════════════════════════╗" << endl;
+    cout << "║      PIPELINE REPORT                 ║" << endl;
+    cout << "╚══════════════════════════════════════╝" << endl;
+    cout << "  • Stages: decode → risk → match → publish" << endl;
+    cout << "  • Total orders processed: " << result.orders << endl;
+    cout << "  • Total trades executed: " << result.trades << endl;
+    cout << "  • Orders rejected: " << result.rejected << endl;
+    if (result.decode_errors > 0)
+    {
+        cout << "  • Unparsed lines: " << result.decode_errors << endl;
+    }
+    cout << "  • Total time: " << result.elapsed_ms << " ms" << endl;
+    cout << "  • Throughput: " << (result.orders * 1000 / max<long long>(result.elapsed_ms, 1LL))
+         << " orders/sec" << endl;
+    cout << "  • Trade checksum: " << hex << setw(16) << setfill('0') << result.trade_checksum
+         << dec << setfill(' ') << endl;
+
+    cout << "\n Decode to publish (μs):" << endl;
+    print_latency_line("all", latency);
+    for (size_t type = 0; type < ReplayPipeline::TYPE_COUNT; type++)
+    {
+        print_latency_line(order_type_name(static_cast<OrderType>(type)), result.by_type[type]);
+    }
+}
+
+void run_engine_benchmark(const string &filename, size_t symbols, size_t shards)
+{
+    ReplayFile replay(filename);
+    if (!replay.is_open())
+    {
+        cerr << "Error: engine mode needs a binary replay file, cannot map " << filename << endl;
+        return;
+    }
+    if (symbols == 0 || shards == 0)
+    {
+        cerr << "Error: need at least one symbol and one shard" << endl;
+        return;
+    }
+
+    EngineConfig engine_config;
+    engine_config.num_shards = shards;
+    MatchingEngine engine(engine_config);
+
+    OrderBookConfig book_config;
+    book_config.order_pool_size = max<size_t>(16384, replay.size() / symbols);
+    book_config.order_index_reserve = book_config.order_pool_size / 4;
+    for (size_t i = 0; i < symbols; i++)
+    {
+        engine.add_symbol(book_config);
+    }
+    engine.for_each_book(setup_demo_risk_limits);
+    vector<const OrderBook *> books;
+    engine.for_each_book([&books](OrderBook &book) { books.push_back(&book); });
+    auto telemetry = start_telemetry(books);
+
+    auto start_time = high_resolution_clock::now();
+    engine.start();
+    for (const ReplayOrder &order : replay)
+    {
+        engine.submit_blocking(EngineMessage{MessageType::NEW_ORDER, static_cast<SymbolId>(order.id % symbols), 0, 0, order});
+    }
+    engine.stop();
+    auto total_time = duration_cast<milliseconds>(high_resolution_clock::now() - start_time).count();
+
+    cout << "\n╔══════════════════════════════════════╗" << endl;
+    cout << "║      MULTI-SYMBOL ENGINE REPORT      ║" << endl;
+    cout << "╚══════════════════════════════════════╝" << endl;
+    cout << "  • Symbols: " << symbols << " across " << shards << " shard(s)" << endl;
+
+    uint64_t total_orders = 0, total_trades = 0, total_rejected = 0;
+    for (size_t i = 0; i < engine.shard_count(); i++)
+    {
+        auto stats = engine.shard_stats(i);
+        cout << "  • Shard " << i << ": " << stats.orders << " orders, " << stats.trades
+             << " trades, " << stats.rejected << " rejected" << endl;
+        total_orders += stats.orders;
+        total_trades += stats.trades;
+        total_rejected += stats.rejected;
+    }
+    cout << "  • Total orders processed: " << total_orders << endl;
+    cout << "  • Total trades executed: " << total_trades << endl;
+    cout << "  • Orders rejected: " << total_rejected << endl;
+    cout << "  • Total time: " << total_time << " ms" << endl;
+    cout << "  • Throughput: " << (total_orders * 1000 / max<long long>(total_time, 1LL))
+         << " orders/sec" << endl;
+}
+
+void run_load_sweep(const string &filename, const vector<double> &rates, size_t max_orders)
+{
+    ReplayFile replay(filename);
+    if (!replay.is_open())
+    {
+        cerr << "Error: load mode needs a binary replay file, cannot map " << filename << endl;
+        return;
+    }
+
+    cout << "\n╔══════════════════════════════════════╗" << endl;
+    cout << "║      OPEN-LOOP LOAD REPORT           ║" << endl;
+    cout << "╚══════════════════════════════════════╝" << endl;
+    cout << "  • Poisson arrivals, x1.5 in open/lunch/close minutes; latency from scheduled arrival (μs)" << endl;
+    cout << "\n" << setw(12) << "target/s" << setw(12) << "offered/s" << setw(12) << "achieved/s"
+         << setw(10) << "p50" << setw(10) << "p99" << setw(11) << "p99.9" << setw(11) << "max"
+         << setw(12) << "svc p99" << setw(12) << "burst p99" << setw(10) << "rejected" << endl;
+
+    for (double rate : rates)
+    {
+        // Fresh book per rate, every point starts from the same state
+        OrderBookConfig config;
+        config.clock.source = ClockSource::GATEWAY;
+        OrderBook book(config);
+        setup_demo_risk_limits(book);
+
+        OpenLoopConfig load;
+        load.rate = rate;
+        load.max_orders = max_orders;
+        OpenLoopResult result;
+        if (!run_open_loop(book, replay, load, result))
+        {
+            cerr << "Error: invalid rate " << rate << endl;
+            return;
+        }
+
+        bool saturated = result.achieved_rate < 0.95 * result.offered_rate;
+        cout << fixed << setprecision(0) << setw(12) << rate << setw(12) << result.offered_rate
+             << setw(12) << result.achieved_rate << setprecision(2)
+             << setw(10) << result.response.percentile(0.50) / 1000.0
+             << setw(10) << result.response.percentile(0.99) / 1000.0
+             << setw(11) << result.response.percentile(0.999) / 1000.0
+             << setw(11) << result.response.max() / 1000.0
+             << setw(12) << result.service.percentile(0.99) / 1000.0
+             << setw(12) << result.burst.percentile(0.99) / 1000.0
+             << setw(10) << result.rejected << (saturated ? "  saturated" : "") << endl;
+    }
+}
+
+void print_book_summary(OrderBook &book)
+{
+    cout << "  • Best bid / ask: " << book.best_bid() << " / " << book.best_ask() << endl;
+    size_t stops = book.get_stop_manager().pending_stop_count();
+    cout << "  • Resting orders: " << book.order_count() - stops << ", pending stops: " << stops << endl;
+}
+
+void run_journaled_replay(const string &filename, const string &directory, ClockSource clock)
+{
+    ReplayFile replay(filename);
+    if (!replay.is_open())
+    {
+        cerr << "Error: journal mode needs a binary replay file, cannot map " << filename << endl;
+        return;
+    }
+
+    OrderBookConfig config;
+    config.clock.source = clock;
+    OrderBook book(config);
+    setup_demo_risk_limits(book);
+
+    PersistenceConfig persistence;
+    persistence.directory = directory;
+    JournaledBook journaled(book, persistence);
+    if (!journaled.is_open() || journaled.last_sequence() != 0)
+    {
+        cerr << "Error: " << directory << " must be a writable directory without a journal" << endl;
+        return;
+    }
+
+    TradeChecksum checksum;
+    size_t order_count = 0;
+    auto start_time = high_resolution_clock::now();
+    for (const ReplayOrder &order : replay)
+    {
+        journaled.add_order(order, checksum);
+        if (++order_count % 1000 == 0)
+        {
+            Price current_price = book.best_bid() > 0 ? (book.best_bid() + book.best_ask()) / 2 : 100000;
+            journaled.mark_to_market(current_price);
+        }
+    }
+    bool synced = journaled.snapshot();
+    auto total_time = duration_cast<milliseconds>(high_resolution_clock::now() - start_time).count();
+
+    cout << "\n╔══════════════════════════════════════╗" << endl;
+    cout << "║      JOURNALED REPLAY REPORT         ║" << endl;
+    cout << "╚══════════════════════════════════════╝" << endl;
+    cout << "  • Total orders processed: " << order_count << endl;
+    cout << "  • Journal records: " << journaled.last_sequence() << (synced ? "" : " (final sync failed)") << endl;
+    cout << "  • Total time: " << total_time << " ms" << endl;
+    cout << "  • Throughput: " << (order_count * 1000 / max<long long>(total_time, 1LL))
+         << " orders/sec" << endl;
+    cout << "  • Trade checksum: " << hex << setw(16) << setfill('0') << checksum.value()
+         << dec << setfill(' ') << endl;
+    print_book_summary(book);
+}
+
+void run_recovery(const string &directory, ClockSource clock)
+{
+    OrderBookConfig config;
+    config.clock.source = clock;
+    OrderBook book(config);
+    // Starting state for a journal without a snapshot; a snapshot overwrites it
+    setup_demo_risk_limits(book);
+
+    RecoveryStats stats = JournaledBook::recover(book, directory);
+    if (!stats.ok)
+    {
+        cerr << "Error: newest snapshot in " << directory << " could not be loaded" << endl;
+        return;
+    }
+
+    cout << "\n╔══════════════════════════════════════╗" << endl;
+    cout << "║      RECOVERY REPORT                 ║" << endl;
+    cout << "╚══════════════════════════════════════╝" << endl;
+    if (stats.snapshot_loaded)
+    {
+        cout << "  • Snapshot at record: " << stats.snapshot_sequence << endl;
+    }
+    else
+    {
+        cout << "  • No snapshot, replayed the journal from the start" << endl;
+    }
+    cout << "  • Journal records replayed: " << stats.replayed << endl;
+    cout << "  • Recovered through record: " << stats.last_sequence << endl;
+    cout << "  • Recovery time: " << stats.elapsed_us / 1000.0 << " ms" << endl;
+    print_book_summary(book);
+}
+
 int main(int argc, char *argv[])
 {
     cout << "==================================================" << endl;
@@ -181,14 +606,77 @@ int main(int argc, char *argv[])
 
     string command = argv[1];
 
-    if (command == "generate" && argc == 4)
+    if (command == "generate" && argc >= 4 && argc <= 6)
     {
-        generate_test_data(argv[2], stoull(argv[3]));
+        // Same seed, same file; threads only change how fast a .bin is written
+        GeneratorConfig config;
+        if (argc >= 5)
+        {
+            config.seed = static_cast<uint32_t>(stoul(argv[4]));
+        }
+        if (argc == 6)
+        {
+            config.threads = stoull(argv[5]);
+        }
+        generate_test_data(argv[2], stoull(argv[3]), config);
         cout << " Market data generated." << endl;
     }
-    else if (command == "run" && argc == 3)
+    else if (command == "run" && argc >= 3 && argc <= 5)
+    {
+        // sim: deterministic 1 us per order, so rate limits replay identically;
+        // a fifth argument journals every L3 event to that file
+        bool simulated = argc >= 4 && string(argv[3]) == "sim";
+        run_benchmark(argv[2], simulated ? ClockSource::SIMULATED : ClockSource::TSC, argc == 5 ? argv[4] : "");
+    }
+    else if (command == "pipeline" && (argc == 3 || argc == 4))
+    {
+        // Same output as run with the same clock, stages on separate cores
+        bool simulated = argc == 4 && string(argv[3]) == "sim";
+        run_pipeline_benchmark(argv[2], simulated ? ClockSource::SIMULATED : ClockSource::TSC);
+    }
+    else if (command == "journal" && (argc == 4 || argc == 5))
+    {
+        // Every input goes to <dir>/journal.wal first, with periodic snapshots
+        bool simulated = argc == 5 && string(argv[4]) == "sim";
+        run_journaled_replay(argv[2], argv[3], simulated ? ClockSource::SIMULATED : ClockSource::TSC);
+    }
+    else if (command == "recover" && (argc == 3 || argc == 4))
+    {
+        bool simulated = argc == 4 && string(argv[3]) == "sim";
+        run_recovery(argv[2], simulated ? ClockSource::SIMULATED : ClockSource::TSC);
+    }
+    else if (command == "engine" && argc == 5)
+    {
+        run_engine_benchmark(argv[2], stoull(argv[3]), stoull(argv[4]));
+    }
+    else if (command == "load" && (argc == 4 || argc == 5))
+    {
+        // Comma-separated target rates in orders/sec, optionally the first N orders only
+        vector<double> rates;
+        stringstream list(argv[3]);
+        string rate;
+        while (getline(list, rate, ','))
+        {
+            rates.push_back(stod(rate));
+        }
+        run_load_sweep(argv[2], rates, argc == 5 ? stoull(argv[4]) : 0);
+    }
+    else if (command == "convert" && argc == 4)
+    {
+        int64_t converted = convert_csv_to_replay(argv[2], argv[3]);
+        if (converted < 0)
+        {
+            cerr << "Error: Cannot convert " << argv[2] << " to " << argv[3] << endl;
+            return 1;
+        }
+        cout << " Converted " << converted << " orders." << endl;
+    }
+    else if (command == "telemetry" && argc >= 3 && argc <= 5)
     {
-        run_benchmark(argv[2]);
+        // Counters of a run started with ENGINE_TELEMETRY=<name>, every interval_ms
+        int64_t interval_ms = argc >= 4 ? stoll(argv[3]) : 1000;
+        size_t samples = argc == 5 ? stoull(argv[4]) : 1;
+        print_telemetry(argv[2], interval_ms, samples);
     }
     else
     {
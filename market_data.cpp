@@ -1,18 +1,19 @@
 #include "market_data.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <thread>
+#include <unistd.h>
 
-void MarketDataGenerator::generate_realistic_order(ofstream &file, size_t order_id, size_t total_count)
+ReplayOrder MarketDataGenerator::generate_realistic_order(size_t order_id, size_t total_count)
 {
-    uniform_int_distribution<> trader_dist(0, 99);
-    uniform_real_distribution<> prob_dist(0.0, 1.0);
-    uniform_real_distribution<> price_offset(-0.005, 0.005); // ±0.5% price variation
-
-    uint32_t trader_id = trader_dist(gen_) + 1;
+    uint32_t trader_id = trader_dist_(gen_) + 1;
     const auto &profile = trader_profiles_[trader_id - 1];
 
     // Determine order type based on trader profile and market conditions
     // Build book first with limit orders, then add crossing orders
-    string order_type;
-    double type_rand = prob_dist(gen_);
+    OrderType order_type;
+    double type_rand = prob_dist_(gen_);
 
     // For first 10% of orders, favor limit orders to build the book
     bool build_book_phase = (order_id <= total_count * 0.1);
@@ -22,11 +23,11 @@ void MarketDataGenerator::generate_realistic_order(ofstream &file, size_t order_
         // Favor limit orders during book building - NO MARKET ORDERS
         if (type_rand < 0.8)
         {
-            order_type = "GTC";
+            order_type = OrderType::GTC;
         }
         else
         {
-            order_type = "ICEBERG";
+            order_type = OrderType::ICEBERG;
         }
     }
     else
@@ -34,23 +35,23 @@ void MarketDataGenerator::generate_realistic_order(ofstream &file, size_t order_
         // Normal trading phase with more aggressive orders
         if (type_rand < profile.aggressiveness * (market_.is_high_volume_period ? 1.5 : 1.0))
         {
-            order_type = "MARKET";
+            order_type = OrderType::MARKET;
         }
         else if (type_rand < profile.aggressiveness + profile.iceberg_probability)
         {
-            order_type = "ICEBERG";
+            order_type = OrderType::ICEBERG;
         }
         else if (type_rand < profile.aggressiveness + profile.iceberg_probability + profile.stop_loss_probability)
         {
-            order_type = "STOP_LOSS";
+            order_type = OrderType::STOP_LOSS;
         }
         else if (type_rand < 0.95)
         {
-            order_type = "GTC";
+            order_type = OrderType::GTC;
         }
         else
         {
-            order_type = (prob_dist(gen_) < 0.5) ? "IOC" : "FOK";
+            order_type = (prob_dist_(gen_) < 0.5) ? OrderType::IOC : OrderType::FOK;
         }
     }
 
@@ -61,29 +62,29 @@ void MarketDataGenerator::generate_realistic_order(ofstream &file, size_t order_
     // Adjust quantity based on time of day and volatility
     if (market_.is_high_volume_period)
     {
-        quantity = static_cast<Quantity>(quantity * (1.0 + prob_dist(gen_) * 0.5)); // Up to 50% larger
+        quantity = static_cast<Quantity>(quantity * (1.0 + prob_dist_(gen_) * 0.5)); // Up to 50% larger
     }
 
     // Determine side with slight momentum bias
     bool is_buy;
     if (abs(market_.momentum) > 0.01)
     {
-        is_buy = (market_.momentum > 0) ? (prob_dist(gen_) < 0.6) : (prob_dist(gen_) < 0.4);
+        is_buy = (market_.momentum > 0) ? (prob_dist_(gen_) < 0.6) : (prob_dist_(gen_) < 0.4);
     }
     else
     {
-        is_buy = prob_dist(gen_) < 0.5;
+        is_buy = prob_dist_(gen_) < 0.5;
     }
 
     // Determine price based on order type and trader profile
     Price order_price = 0;
     Price stop_price = 0;
 
-    if (order_type == "MARKET")
+    if (order_type == OrderType::MARKET)
     {
         order_price = 0; // Market orders have no price limit
     }
-    else if (order_type == "STOP_LOSS")
+    else if (order_type == OrderType::STOP_LOSS)
     {
         // Stop orders: 2-5% away from current price
         uniform_real_distribution<> stop_dist(0.02, 0.05);
@@ -112,11 +113,11 @@ void MarketDataGenerator::generate_realistic_order(ofstream &file, size_t order_
             if (is_buy)
             {
                 // Market makers bid inside the spread or occasionally cross
-                if (prob_dist(gen_) < 0.2) // Only 20% chance to cross spread
+                if (prob_dist_(gen_) < 0.2) // Only 20% chance to cross spread
                 {
                     order_price = market_.ask_price; // Cross the spread aggressively
                 }
-                else if (prob_dist(gen_) < 0.7) // 50% at current bid
+                else if (prob_dist_(gen_) < 0.7) // 50% at current bid
                 {
                     order_price = market_.bid_price; // At best bid
                 }
@@ -128,11 +129,11 @@ void MarketDataGenerator::generate_realistic_order(ofstream &file, size_t order_
             else
             {
                 // Market makers offer inside the spread or occasionally cross
-                if (prob_dist(gen_) < 0.2) // Only 20% chance to cross spread
+                if (prob_dist_(gen_) < 0.2) // Only 20% chance to cross spread
                 {
                     order_price = market_.bid_price; // Cross the spread aggressively
                 }
-                else if (prob_dist(gen_) < 0.7) // 50% at current ask
+                else if (prob_dist_(gen_) < 0.7) // 50% at current ask
                 {
                     order_price = market_.ask_price; // At best ask
                 }
@@ -178,19 +179,131 @@ void MarketDataGenerator::generate_realistic_order(ofstream &file, size_t order_
     Quantity display_size = quantity;
     Quantity disp = quantity;
 
-    if (order_type == "ICEBERG")
+    if (order_type == OrderType::ICEBERG)
     {
         uniform_int_distribution<> iceberg_dist(quantity / 10, quantity / 3);
         display_size = min(quantity, static_cast<Quantity>(iceberg_dist(gen_)));
         disp = display_size;
     }
 
-    uint32_t session_id = (order_id % 500) + 1;
+    ReplayOrder order{};
+    order.id = order_id;
+    order.side = static_cast<uint8_t>(is_buy ? Side::BUY : Side::SELL);
+    order.price = order_price;
+    order.stop_price = stop_price;
+    order.quantity = static_cast<int32_t>(quantity);
+    order.disp = static_cast<int32_t>(disp);
+    order.display_size = static_cast<int32_t>(display_size);
+    order.owner = trader_id;
+    order.session_id = (order_id % 500) + 1;
+    order.type = static_cast<uint8_t>(order_type);
+    return order;
+}
+
+void MarketDataGenerator::write_csv_order(ofstream &file, const ReplayOrder &order)
+{
+    // One formatted row per write, no temporaries
+    char row[192];
+    int length = snprintf(row, sizeof(row), "%llu,%s,%lld,%d,%s,%d,%d,%u,%lld,%u,192.168.%llu.%llu\n",
+                          static_cast<unsigned long long>(order.id),
+                          static_cast<Side>(order.side) == Side::BUY ? "BUY" : "SELL",
+                          static_cast<long long>(order.price), order.quantity,
+                          order_type_name(static_cast<OrderType>(order.type)), order.disp, order.display_size,
+                          order.owner, static_cast<long long>(order.stop_price), order.session_id,
+                          static_cast<unsigned long long>((order.id % 200) / 50),
+                          static_cast<unsigned long long>((order.id % 50) + 1));
+    file.write(row, min<int>(length, sizeof(row) - 1));
+}
+
+namespace
+{
+    // splitmix64 finalizer: well-spread stream seeds from (seed, slice)
+    uint32_t slice_seed(uint32_t seed, size_t slice)
+    {
+        if (slice == 0)
+            return seed;
+        uint64_t z = seed + slice * 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return static_cast<uint32_t>(z ^ (z >> 31));
+    }
+
+    bool write_at(int fd, const void *data, size_t size, off_t offset)
+    {
+        const char *bytes = static_cast<const char *>(data);
+        while (size > 0)
+        {
+            ssize_t written = pwrite(fd, bytes, size, offset);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            bytes += written;
+            size -= static_cast<size_t>(written);
+            offset += written;
+        }
+        return true;
+    }
+}
+
+int64_t generate_replay_file(const string &filename, size_t count, const GeneratorConfig &config)
+{
+    int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return -1;
+
+    ReplayHeader header{};
+    memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+    header.version = REPLAY_VERSION;
+    header.record_size = sizeof(ReplayOrder);
+    header.count = count;
+    bool ok = write_at(fd, &header, sizeof(header), 0) &&
+              ftruncate(fd, static_cast<off_t>(sizeof(header) + count * sizeof(ReplayOrder))) == 0;
 
-    string ip_address = "192.168." + to_string((order_id % 200) / 50) + "." + to_string((order_id % 50) + 1);
+    size_t slice_orders = max<size_t>(config.slice_orders, 1);
+    size_t batch_orders = max<size_t>(config.batch_orders, 1);
+    size_t slices = (count + slice_orders - 1) / slice_orders;
+    size_t threads = config.threads > 0 ? config.threads : max(thread::hardware_concurrency(), 1u);
+    threads = max<size_t>(min(threads, slices), 1);
+
+    // Threads take whole slices; where a slice lands in the file is fixed
+    atomic<size_t> next_slice{0};
+    atomic<bool> failed{!ok};
+    auto worker = [&]()
+    {
+        vector<ReplayOrder> batch(batch_orders);
+        for (size_t slice = next_slice++; slice < slices && !failed.load(memory_order_relaxed); slice = next_slice++)
+        {
+            size_t first = slice * slice_orders;
+            size_t last = min(first + slice_orders, count);
+            MarketDataGenerator generator(slice_seed(config.seed, slice), first + 1);
+            for (size_t start = first; start < last; start += batch_orders)
+            {
+                size_t n = min(batch_orders, last - start);
+                generator.generate_orders(start + 1, n, count, batch.data());
+                off_t offset = static_cast<off_t>(sizeof(header) + start * sizeof(ReplayOrder));
+                if (!write_at(fd, batch.data(), n * sizeof(ReplayOrder), offset))
+                {
+                    failed = true;
+                    break;
+                }
+            }
+        }
+    };
+
+    vector<thread> pool;
+    for (size_t i = 1; i < threads; i++)
+    {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (thread &t : pool)
+    {
+        t.join();
+    }
 
-    file << order_id << "," << (is_buy ? "BUY" : "SELL") << ","
-         << order_price << "," << quantity << ","
-         << order_type << "," << disp << "," << display_size << "," << trader_id
-         << "," << stop_price << "," << session_id << "," << ip_address << "\n";
-}
\ No newline at end of file
+    ok = ::close(fd) == 0 && !failed.load();
+    return ok ? static_cast<int64_t>(count) : -1;
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "types.h"
 #include "tick_table.h"
+#include "replay_format.h"
 
 class MarketDataGenerator
 {
@@ -37,13 +38,35 @@ private:
     vector<TraderProfile> trader_profiles_;
     TickSizeTable tick_table_;
 
+    // Fixed-range distributions are stateless, built once instead of per order
+    uniform_int_distribution<> trader_dist_;
+    uniform_real_distribution<> prob_dist_;
+
     Price round_to_valid_tick(Price price) const
     {
         return tick_table_.round_to_tick(price);
     }
 
+    void update_volume_period()
+    {
+        market_.is_high_volume_period = is_high_volume_minute(market_.time_of_day);
+    }
+
 public:
-    MarketDataGenerator(int seed = 42) : gen_(seed)
+    static bool is_high_volume_minute(size_t minute)
+    {
+        return (minute < 30) ||                 // Market open
+               (minute > 360) ||                // Market close
+               (minute >= 90 && minute <= 120); // Lunch time spike
+    }
+
+    // Minute of the trading day an order id was generated in
+    static size_t market_minute(size_t order_id) { return (order_id / 50) % 390; }
+
+    // first_order_id places a generator for a later slice of the day at
+    // that slice's time of day; the market updates every 50 orders
+    explicit MarketDataGenerator(uint32_t seed = 42, size_t first_order_id = 1)
+        : gen_(seed), trader_dist_(0, 99), prob_dist_(0.0, 1.0)
     {
         // Initialize market state - use $1000 range like unit tests
         market_.last_price = 100000;                     // $1000.00
@@ -51,8 +74,8 @@ public:
         market_.ask_price = round_to_valid_tick(100001); // $1000.01
         market_.volatility = 0.02;                       // 2% daily volatility
         market_.momentum = 0.0;
-        market_.time_of_day = 0;
-        market_.is_high_volume_period = true;
+        market_.time_of_day = ((max<size_t>(first_order_id, 1) - 1) / 50) % 390;
+        update_volume_period();
 
         setup_trader_profiles();
     }
@@ -125,10 +148,7 @@ public:
 
         // Time-based volume patterns
         market_.time_of_day = (market_.time_of_day + 1) % 390; // 6.5 hour trading day
-        market_.is_high_volume_period =
-            (market_.time_of_day < 30) ||                              // Market open
-            (market_.time_of_day > 360) ||                             // Market close
-            (market_.time_of_day >= 90 && market_.time_of_day <= 120); // Lunch time spike
+        update_volume_period();
 
         // Price discovery with bounded random walk + mean reversion
         normal_distribution<> price_change(market_.momentum * 0.1, market_.volatility * 0.01);
@@ -167,7 +187,23 @@ public:
         }
     }
 
-    void generate_realistic_order(ofstream &file, size_t order_id, size_t total_count);
+    ReplayOrder generate_realistic_order(size_t order_id, size_t total_count);
+    static void write_csv_order(ofstream &file, const ReplayOrder &order);
+
+    // Orders first_order_id .. first_order_id + count - 1 of a total_count
+    // day into out, updating the market every 50 orders like a full run
+    void generate_orders(size_t first_order_id, size_t count, size_t total_count, ReplayOrder *out)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t order_id = first_order_id + i;
+            if (order_id % 50 == 0)
+            {
+                update_market_dynamics();
+            }
+            out[i] = generate_realistic_order(order_id, total_count);
+        }
+    }
 
     void print_market_state() const
     {
@@ -182,4 +218,19 @@ public:
              << setfill('0') << setw(2) << (market_.time_of_day % 60) << "m"
              << (market_.is_high_volume_period ? " (High Volume)" : " (Normal Volume)") << endl;
     }
-};
\ No newline at end of file
+};
+struct GeneratorConfig
+{
+    uint32_t seed = 42;
+    size_t slice_orders = 1 << 20; // orders per independent stream, part of what the output depends on
+    size_t threads = 0;            // 0 = one per hardware thread; never changes the output
+    size_t batch_orders = 4096;    // records generated and written per batch
+};
+
+// Writes a count-order day straight into a binary replay file. The day is
+// cut into time slices of slice_orders, each generated by its own stream
+// seeded from (seed, slice) at its own time of day and written at its
+// fixed offset, so the file is identical for any thread count. Slice 0
+// uses seed itself: a day of one slice equals the sequential generator.
+// Returns the number of orders written, or -1 on I/O error.
+int64_t generate_replay_file(const string &filename, size_t count, const GeneratorConfig &config = GeneratorConfig{});
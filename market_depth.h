@@ -0,0 +1,66 @@
+#pragma once
+#include "types.h"
+
+// Aggregated view of one price level
+struct L2Level
+{
+    Price price;
+    int64_t quantity; // displayed quantity
+    uint32_t order_count;
+};
+
+enum class L2Action : uint8_t
+{
+    ADD,    // level appeared
+    CHANGE, // quantity or order count changed
+    DELETE  // level is gone, quantity and count are 0
+};
+
+// One level's state after an inbound message
+struct L2Delta
+{
+    Price price;
+    int64_t quantity;
+    uint32_t order_count;
+    Side side;
+    L2Action action;
+};
+
+static_assert(sizeof(L2Delta) == 24, "L2 delta should stay compact");
+
+// Every level an inbound message changed, sorted by side then price. Each
+// level appears once with its final state; valid only during the callback.
+struct L2Update
+{
+    uint64_t sequence; // one per message that changed the book
+    const L2Delta *first;
+    const L2Delta *last;
+
+    const L2Delta *begin() const { return first; }
+    const L2Delta *end() const { return last; }
+    size_t size() const { return last - first; }
+};
+
+// Non-owning reference to the book's L2 subscriber, set once and called
+// after each message that changed a level. The callable must outlive the
+// book or be detached first. Empty by default, then the book tracks nothing.
+class L2Sink
+{
+private:
+    void *ctx_;
+    void (*emit_)(void *, const L2Update &);
+
+public:
+    L2Sink() : ctx_(nullptr), emit_(nullptr) {}
+
+    template <typename Fn, typename = enable_if_t<!is_same_v<decay_t<Fn>, L2Sink>>>
+    L2Sink(Fn &fn)
+        : ctx_(const_cast<void *>(static_cast<const void *>(&fn))),
+          emit_([](void *ctx, const L2Update &update)
+                { (*static_cast<Fn *>(ctx))(update); })
+    {
+    }
+
+    explicit operator bool() const { return emit_ != nullptr; }
+    void operator()(const L2Update &update) const { emit_(ctx_, update); }
+};
@@ -0,0 +1,175 @@
+#include "matching_engine.h"
+
+MatchingEngine::MatchingEngine(const EngineConfig &config)
+    : config_(config), risk_(config.max_traders), running_(false), started_(false)
+{
+    if (config_.num_shards == 0)
+    {
+        throw invalid_argument("Matching engine needs at least one shard");
+    }
+
+    unsigned hardware_threads = max(1u, thread::hardware_concurrency());
+    for (size_t i = 0; i < config_.num_shards; i++)
+    {
+        int core = i < config_.cores.size() ? config_.cores[i] : static_cast<int>(i % hardware_threads);
+        shards_.push_back(make_unique<Shard>(config_.queue_capacity, core));
+    }
+}
+
+MatchingEngine::~MatchingEngine()
+{
+    stop();
+}
+
+SymbolId MatchingEngine::add_symbol(const OrderBookConfig &config)
+{
+    return add_symbol(config, routes_.size() % shards_.size());
+}
+
+SymbolId MatchingEngine::add_symbol(const OrderBookConfig &config, size_t shard)
+{
+    if (started_)
+    {
+        throw logic_error("Symbols must be added before the engine starts");
+    }
+    if (shard >= shards_.size())
+    {
+        throw out_of_range("Shard index out of range");
+    }
+
+    // Books are built here but matched on the shard's core, so their memory
+    // belongs on that core's node rather than this thread's
+    OrderBookConfig book_config = config;
+    if (book_config.arena.numa_node == ArenaConfig::CALLER_NODE)
+    {
+        book_config.arena.numa_node = numa_node_of_cpu(shards_[shard]->core);
+    }
+
+    auto &books = shards_[shard]->books;
+    routes_.push_back(Route{static_cast<uint32_t>(shard), static_cast<uint32_t>(books.size())});
+    books.push_back(make_unique<OrderBook>(book_config));
+    books.back()->get_risk_manager().attach_shared_risk(&risk_);
+    return static_cast<SymbolId>(routes_.size() - 1);
+}
+
+void MatchingEngine::start()
+{
+    if (started_)
+        return;
+
+    started_ = true;
+    running_.store(true, memory_order_release);
+    for (auto &shard : shards_)
+    {
+        Shard *s = shard.get();
+        s->worker = thread([this, s]
+                           { run_shard(*s); });
+    }
+}
+
+void MatchingEngine::stop()
+{
+    if (!started_)
+        return;
+
+    running_.store(false, memory_order_release);
+    for (auto &shard : shards_)
+    {
+        if (shard->worker.joinable())
+        {
+            shard->worker.join();
+        }
+    }
+    started_ = false;
+}
+
+void MatchingEngine::run_shard(Shard &shard)
+{
+    pin_thread_to_core(shard.core);
+
+    uint64_t orders = 0, trades = 0, rejected = 0, cancels = 0;
+    unsigned idle_spins = 0;
+    EngineMessage message;
+
+    while (true)
+    {
+        if (!shard.inbound.try_pop(message))
+        {
+            if (!running_.load(memory_order_acquire) && shard.inbound.empty())
+                break;
+
+            // Publish counters while idle rather than per message
+            shard.orders.store(orders, memory_order_relaxed);
+            shard.trades.store(trades, memory_order_relaxed);
+            shard.rejected.store(rejected, memory_order_relaxed);
+            shard.cancels.store(cancels, memory_order_relaxed);
+
+            idle_backoff(idle_spins);
+            continue;
+        }
+        idle_spins = 0;
+
+        OrderBook &book = *shard.books[message.book_slot];
+        book.clock().set_gateway_time(message.timestamp);
+        if (message.type == MessageType::NEW_ORDER)
+        {
+            ExecutionReport report = replay_order(book, message.order, [](const Trade &) {});
+            orders++;
+            trades += report.trade_count;
+            if (report.status == ExecStatus::REJECTED_RISK || report.status == ExecStatus::REJECTED_NO_MEMORY)
+            {
+                rejected++;
+            }
+        }
+        else if (book.cancel_order(message.order.id))
+        {
+            cancels++;
+        }
+    }
+
+    shard.orders.store(orders, memory_order_relaxed);
+    shard.trades.store(trades, memory_order_relaxed);
+    shard.rejected.store(rejected, memory_order_relaxed);
+    shard.cancels.store(cancels, memory_order_relaxed);
+}
+
+bool MatchingEngine::submit(const EngineMessage &message)
+{
+    if (message.symbol >= routes_.size())
+        return false;
+
+    const Route &route = routes_[message.symbol];
+    EngineMessage routed = message;
+    routed.book_slot = route.slot;
+    return shards_[route.shard]->inbound.try_push(routed);
+}
+
+void MatchingEngine::submit_blocking(const EngineMessage &message)
+{
+    if (message.symbol >= routes_.size())
+        return;
+
+    while (!submit(message))
+    {
+        cpu_relax();
+    }
+}
+
+bool MatchingEngine::submit_order(SymbolId symbol, const ReplayOrder &order)
+{
+    return submit(EngineMessage{MessageType::NEW_ORDER, symbol, 0, TscClock::now_ns(), order});
+}
+
+bool MatchingEngine::cancel_order(SymbolId symbol, OrderId id)
+{
+    ReplayOrder order{};
+    order.id = id;
+    return submit(EngineMessage{MessageType::CANCEL_ORDER, symbol, 0, TscClock::now_ns(), order});
+}
+
+MatchingEngine::ShardStats MatchingEngine::shard_stats(size_t shard) const
+{
+    const Shard &s = *shards_[shard];
+    return ShardStats{s.orders.load(memory_order_relaxed), s.trades.load(memory_order_relaxed),
+                      s.rejected.load(memory_order_relaxed), s.cancels.load(memory_order_relaxed)};
+}
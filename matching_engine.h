@@ -0,0 +1,121 @@
+#pragma once
+#include "order_book.h"
+#include "spsc_queue.h"
+#include "replay_format.h"
+#include <thread>
+
+using SymbolId = uint32_t;
+
+enum class MessageType : uint8_t
+{
+    NEW_ORDER,
+    CANCEL_ORDER
+};
+
+struct EngineMessage
+{
+    MessageType type;
+    SymbolId symbol;
+    uint32_t book_slot; // filled in when routed
+    int64_t timestamp;  // gateway receive time, used by books on a GATEWAY clock
+    ReplayOrder order;  // CANCEL_ORDER only uses order.id
+};
+
+struct EngineConfig
+{
+    size_t num_shards = 1;
+    vector<int> cores; // core per shard, empty = shard i on core i % hardware threads
+    size_t queue_capacity = 65536;
+    size_t max_traders = 65536; // ownerIDs the shared risk service can hold
+};
+
+// Owns many single-instrument books split into shards. Each shard is one
+// matcher thread pinned to its own core, fed by an SPSC queue from the
+// gateway, and owns its books outright, so shards share no locks. Risk
+// limits and per-trader totals live in one SharedRiskService for all books.
+class MatchingEngine
+{
+public:
+    struct ShardStats
+    {
+        uint64_t orders;
+        uint64_t trades;
+        uint64_t rejected;
+        uint64_t cancels;
+    };
+
+private:
+    struct Route
+    {
+        uint32_t shard;
+        uint32_t slot;
+    };
+
+    struct Shard
+    {
+        vector<unique_ptr<OrderBook>> books;
+        SpscQueue<EngineMessage> inbound;
+        thread worker;
+        int core;
+
+        alignas(64) atomic<uint64_t> orders{0};
+        atomic<uint64_t> trades{0};
+        atomic<uint64_t> rejected{0};
+        atomic<uint64_t> cancels{0};
+
+        Shard(size_t queue_capacity, int core) : inbound(queue_capacity), core(core) {}
+    };
+
+    EngineConfig config_;
+    SharedRiskService risk_;
+    vector<unique_ptr<Shard>> shards_;
+    vector<Route> routes_;
+    atomic<bool> running_;
+    bool started_;
+
+    void run_shard(Shard &shard);
+
+public:
+    explicit MatchingEngine(const EngineConfig &config = EngineConfig{});
+    ~MatchingEngine();
+
+    MatchingEngine(const MatchingEngine &) = delete;
+    MatchingEngine &operator=(const MatchingEngine &) = delete;
+
+    // Setup, only before start(). Symbols without an explicit shard go round-robin.
+    SymbolId add_symbol(const OrderBookConfig &config = OrderBookConfig{});
+    SymbolId add_symbol(const OrderBookConfig &config, size_t shard);
+
+    template <typename Fn>
+    void for_each_book(Fn &&fn)
+    {
+        for (auto &shard : shards_)
+        {
+            for (auto &book : shard->books)
+            {
+                fn(*book);
+            }
+        }
+    }
+
+    void start();
+    void stop(); // drains every queue, then joins the matchers
+
+    // Gateway side, from a single producer thread. Returns false if the
+    // symbol is unknown or its shard's queue is full.
+    bool submit(const EngineMessage &message);
+    void submit_blocking(const EngineMessage &message);
+    bool submit_order(SymbolId symbol, const ReplayOrder &order);
+    bool cancel_order(SymbolId symbol, OrderId id);
+
+    SharedRiskService &risk() { return risk_; }
+
+    size_t symbol_count() const { return routes_.size(); }
+    size_t shard_count() const { return shards_.size(); }
+    size_t shard_of(SymbolId symbol) const { return routes_[symbol].shard; }
+
+    // Owned by the shard thread while running, inspect only when stopped
+    OrderBook &book(SymbolId symbol) { return *shards_[routes_[symbol].shard]->books[routes_[symbol].slot]; }
+
+    ShardStats shard_stats(size_t shard) const;
+};
@@ -1,7 +1,15 @@
 #pragma once
 #include "types.h"
 
-template <typename T>
+// Pool policies, picked per pool as the second template argument
+struct LockedPool       // mutex on every call, every release validated
+{
+};
+struct SingleThreadPool // one owning thread, no locks, debug-only validation
+{
+};
+
+template <typename T, typename Policy = LockedPool>
 class ObjectPool
 {
 private:
@@ -101,18 +109,7 @@ public:
 private:
     void reset_order(Order *order)
     {
-        order->id = 0;
-        order->price = 0;
-        order->stop_price = 0;
-        order->quantity = 0;
-        order->remaining = 0;
-        order->display = 0;
-        order->display_size = 0;
-        order->timestamp = 0;
-        order->ownerID = 0;
-        order->is_triggered = false;
-        order->parent_id = 0;
-        order->session_id = 0;
+        *order = Order();
     }
 
     void reset_trade(Trade *trade)
@@ -123,4 +120,117 @@ private:
         trade->sell_id = 0;
         trade->timestamp = 0;
     }
-};
\ No newline at end of file
+};
+
+// Contiguous slabs of slots with the free list threaded through the slots
+// themselves, for the lock-free policy
+template <typename T>
+class PoolSlab
+{
+protected:
+    union Slot
+    {
+        T object;
+        Slot *next_free;
+
+        Slot() : next_free(nullptr) {}
+        ~Slot() {}
+    };
+
+    vector<unique_ptr<Slot[]>> slabs_;
+    vector<size_t> slab_sizes_;
+    size_t capacity_ = 0;
+
+    static Slot *to_slot(T *obj) { return reinterpret_cast<Slot *>(obj); }
+
+    // Allocate a slab of count slots linked in address order onto tail
+    Slot *add_slab(size_t count, Slot *tail)
+    {
+        if (count == 0 || count > SIZE_MAX / sizeof(Slot))
+        {
+            throw bad_alloc();
+        }
+        auto slab = make_unique<Slot[]>(count);
+        Slot *slots = slab.get();
+        for (size_t i = 0; i + 1 < count; i++)
+        {
+            slots[i].next_free = &slots[i + 1];
+        }
+        slots[count - 1].next_free = tail;
+
+        slabs_.push_back(std::move(slab));
+        slab_sizes_.push_back(count);
+        capacity_ += count;
+        return slots;
+    }
+
+    bool owns(const T *obj) const
+    {
+        auto addr = reinterpret_cast<uintptr_t>(obj);
+        for (size_t i = 0; i < slabs_.size(); i++)
+        {
+            auto begin = reinterpret_cast<uintptr_t>(slabs_[i].get());
+            auto end = begin + slab_sizes_[i] * sizeof(Slot);
+            if (addr >= begin && addr < end && (addr - begin) % sizeof(Slot) == 0)
+                return true;
+        }
+        return false;
+    }
+};
+
+template <typename T>
+class ObjectPool<T, SingleThreadPool> : private PoolSlab<T>
+{
+private:
+    using Slot = typename PoolSlab<T>::Slot;
+
+    Slot *free_head_;
+    size_t allocated_count_;
+
+public:
+    ObjectPool(size_t initial_size = 10000) : free_head_(nullptr), allocated_count_(0)
+    {
+        if (initial_size > 0)
+        {
+            free_head_ = this->add_slab(initial_size, nullptr);
+        }
+    }
+
+    T *acquire()
+    {
+        if (free_head_ == nullptr)
+        {
+            expand_pool();
+        }
+
+        Slot *slot = free_head_;
+        free_head_ = slot->next_free;
+        allocated_count_++;
+        return new (&slot->object) T();
+    }
+
+    void release(T *obj)
+    {
+        if (obj == nullptr)
+            return;
+        assert(this->owns(obj) && "object does not belong to this pool");
+
+        obj->~T();
+        Slot *slot = this->to_slot(obj);
+        slot->next_free = free_head_;
+        free_head_ = slot;
+        allocated_count_--;
+    }
+
+    size_t available_count() const { return this->capacity_ - allocated_count_; }
+    size_t allocated_count() const { return allocated_count_; }
+    size_t total_capacity() const { return this->capacity_; }
+
+    void expand_pool(size_t additional_size = 1000)
+    {
+        if (additional_size > 0)
+        {
+            free_head_ = this->add_slab(additional_size, free_head_);
+        }
+    }
+};
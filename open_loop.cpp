@@ -0,0 +1,72 @@
+#include "open_loop.h"
+#include "market_data.h"
+#include "spsc_queue.h"
+
+bool run_open_loop(OrderBook &book, const ReplayFile &replay, const OpenLoopConfig &config, OpenLoopResult &result)
+{
+    result = OpenLoopResult{};
+    if (!replay.is_open() || config.rate <= 0 || book.clock().source() != ClockSource::GATEWAY)
+        return false;
+
+    size_t count = config.max_orders > 0 ? min(config.max_orders, replay.size()) : replay.size();
+    mt19937_64 gen(config.seed);
+    exponential_distribution<> gap_dist(1.0);
+    double normal_gap_ns = 1e9 / config.rate;
+    double burst_gap_ns = normal_gap_ns / max(config.burst_factor, 1e-9);
+
+    TradeChecksum checksum;
+    double due_offset = 0;
+    int64_t last_done = 0;
+    int64_t start = TscClock::now_ns();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const ReplayOrder &order = replay[i];
+        bool high_volume = MarketDataGenerator::is_high_volume_minute(MarketDataGenerator::market_minute(order.id));
+        double gap = high_volume ? burst_gap_ns : normal_gap_ns;
+        due_offset += config.poisson ? gap * gap_dist(gen) : gap;
+
+        // Wait for the due time; an order already overdue goes straight in
+        int64_t scheduled = static_cast<int64_t>(due_offset);
+        int64_t due = start + scheduled;
+        int64_t send = TscClock::now_ns();
+        while (send < due)
+        {
+            cpu_relax();
+            send = TscClock::now_ns();
+        }
+
+        book.clock().set_gateway_time(scheduled);
+        ExecutionReport report = replay_order(book, order, checksum);
+        last_done = TscClock::now_ns();
+
+        result.response.record(last_done - due);
+        result.service.record(last_done - send);
+        if (high_volume)
+        {
+            result.burst.record(last_done - due);
+        }
+
+        result.orders++;
+        result.trades += report.trade_count;
+        if (report.status == ExecStatus::REJECTED_RISK || report.status == ExecStatus::REJECTED_NO_MEMORY)
+        {
+            result.rejected++;
+        }
+
+        // Same cadence as the serial run
+        if (config.mark_interval > 0 && result.orders % config.mark_interval == 0)
+        {
+            Price current_price = book.best_bid() > 0 ? (book.best_bid() + book.best_ask()) / 2 : 100000;
+            book.get_risk_manager().mark_to_market(current_price);
+        }
+    }
+
+    result.trade_checksum = checksum.value();
+    if (result.orders > 0)
+    {
+        result.offered_rate = result.orders * 1e9 / max(due_offset, 1.0);
+        result.achieved_rate = result.orders * 1e9 / max<double>(last_done - start, 1.0);
+    }
+    return true;
+}
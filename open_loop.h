@@ -0,0 +1,40 @@
+#pragma once
+#include "order_book.h"
+#include "replay_format.h"
+
+struct OpenLoopConfig
+{
+    double rate = 100000;      // orders/sec in normal-volume minutes
+    double burst_factor = 1.5; // rate multiplier in the generator's open, lunch and close minutes; 1 = flat
+    bool poisson = true;       // exponential gaps, otherwise evenly spaced
+    uint32_t seed = 42;        // arrival gaps only, the orders come from the file
+    size_t max_orders = 0;     // 0 = whole file
+    size_t mark_interval = 1000;
+};
+
+struct OpenLoopResult
+{
+    uint64_t orders = 0;
+    uint64_t trades = 0;
+    uint64_t rejected = 0;
+    uint64_t trade_checksum = 0;
+    double offered_rate = 0;  // orders over the scheduled span
+    double achieved_rate = 0; // orders over first arrival to last completion
+    LatencyHistogram response; // scheduled arrival to completion, queueing included
+    LatencyHistogram service;  // send to completion, what a closed loop reports
+    LatencyHistogram burst;    // response time in high-volume minutes only
+};
+
+// Open-loop replay: order i is due at a time fixed by the arrival schedule,
+// not by when order i - 1 finished. The loop waits for each due time and
+// sends late orders at once, so latency is measured from when the order was
+// due and a stall shows up in every order queued behind it rather than in
+// one slow sample (no coordinated omission).
+//
+// The replay format carries no timestamps, so arrivals are scheduled from
+// the configured rate shaped by the generator's time of day: each order's
+// market minute comes from its id, as in MarketDataGenerator. The book must
+// use ClockSource::GATEWAY; every order is stamped with its scheduled time,
+// so rate limits and fills depend on the schedule alone and a given rate
+// and seed always produce the same trades.
+bool run_open_loop(OrderBook &book, const ReplayFile &replay, const OpenLoopConfig &config, OpenLoopResult &result);
@@ -4,454 +4,803 @@ vector<Trade> OrderBook::add_order(OrderId id, Side side, Price price, Quantity
                         Quantity disp, Quantity display_size, OrderType type,
                         uint32_t ownerID, Price stop_price, uint32_t session_id)
 {
-
-    if (session_id != 0)
-    {
-        // Session validation for production use
-    }
-    stats_.totalOrders++;
     vector<Trade> trades;
-    trades.reserve(16);
+    add_order(id, side, price, qty, disp, display_size, type, ownerID, stop_price, session_id,
+              [&](const Trade &trade)
+              { trades.push_back(trade); });
+    return trades;
+}
 
-    Order *order_ptr = order_pool_.acquire();
-    if (order_ptr == nullptr)
+ScreenedOrder OrderBook::screen_order(Price price, Quantity qty, Quantity disp, OrderType type,
+                                      uint32_t ownerID, Price stop_price) const
+{
+    ScreenedOrder screened{RiskManager::RiskResult::APPROVED, price, stop_price};
+
+    // The hot record keeps quantities in 32 bits
+    if (qty < 0 || qty > MAX_ORDER_QUANTITY || disp < 0 || disp > MAX_ORDER_QUANTITY)
     {
-        return {};
+        screened.risk_result = RiskManager::RiskResult::REJECTED_ORDER_SIZE;
+        return screened;
     }
-    *order_ptr = Order(id, side, price, stop_price, qty, disp, display_size, type, ownerID, session_id);
 
-    if (type != OrderType::MARKET && price > 0)
+    // A limit needs a price on the tick grid; one off it would also push
+    // the ladder out of ARRAY mode for good
+    if (type != OrderType::MARKET && type != OrderType::STOP_LOSS)
     {
         Price rounded_price = tick_table_.round_to_tick(price);
-        if (rounded_price > 0)
+        if (rounded_price <= 0)
         {
-            order_ptr->price = rounded_price;
+            screened.risk_result = RiskManager::RiskResult::REJECTED_INVALID_TICK_SIZE;
+            return screened;
         }
+        screened.price = rounded_price;
     }
     if (stop_price > 0)
     {
         Price rounded_stop = tick_table_.round_to_tick(stop_price);
         if (rounded_stop > 0)
         {
-            order_ptr->stop_price = rounded_stop;
+            screened.stop_price = rounded_stop;
         }
     }
 
-    auto risk_result = risk_manager_.check_order(*order_ptr);
-    if (risk_result != RiskManager::RiskResult::APPROVED)
+    screened.risk_result = risk_manager_.check_static(ownerID, type, screened.price, qty);
+    return screened;
+}
+
+ExecutionReport OrderBook::submit_order(OrderId id, Side side, Price price, Quantity qty,
+                                        Quantity disp, Quantity display_size, OrderType type,
+                                        uint32_t ownerID, Price stop_price, uint32_t session_id,
+                                        TradeSink sink, const ScreenedOrder *screened)
+{
+    stats_.totalOrders++;
+    message_time_ = clock_.message_time();
+    ExecutionReport report{};
+    if (session_rejected(session_id))
     {
-        order_pool_.release(order_ptr);
-        stats_.totalRiskRejected++;
-        return {};
+        report.status = ExecStatus::REJECTED_SESSION;
+        return report;
     }
+    uint64_t trades_before = stats_.totalTrades;
+    uint64_t stops_before = stats_.totalStopTriggered;
 
-    if (type == OrderType::STOP_LOSS)
+    ScreenedOrder screen;
+    if (screened)
     {
-        stop_manager_.add_stop_order(order_ptr);
-        orders_[id] = order_ptr;
-        return {};
+        screen = *screened;
     }
-    else if (type == OrderType::FOK)
+    else
     {
-        bool filled = add_FOK_order(order_ptr, trades);
-        if (filled)
-        {
-            stats_.totalTrades += trades.size();
-            for (auto &trade : trades)
-            {
-                stats_.totalVolumes += trade.quantity;
-            }
-        }
-        order_pool_.release(order_ptr);
-        process_triggered_stops(trades);
-        return trades;
+        STAGE_TIMER(stage_timers_.screen);
+        ENGINE_PROBE(risk_begin, id);
+        screen = screen_order(price, qty, disp, type, ownerID, stop_price);
+        ENGINE_PROBE(risk_end, static_cast<uint64_t>(screen.risk_result));
     }
-
-    if (type == OrderType::MARKET)
+    if (screen.risk_result != RiskManager::RiskResult::APPROVED)
     {
-        add_market_order(order_ptr, trades);
-        stats_.totalTrades += trades.size();
-        for (auto &trade : trades)
-        {
-            stats_.totalVolumes += trade.quantity;
-        }
-        order_pool_.release(order_ptr);
-        process_triggered_stops(trades);
-        return trades;
+        count_risk_reject(screen.risk_result);
+        report.risk_result = screen.risk_result;
+        report.status = ExecStatus::REJECTED_RISK;
+        return report;
     }
 
-    if (side == Side::BUY)
+    Order *order_ptr = acquire_order();
+    if (order_ptr == nullptr)
     {
-        auto &opposite = asks_;
-        while (order_ptr->display > 0 && !opposite.empty())
-        {
-            auto &[best_price, level] = *opposite.begin();
-            if (price < best_price)
-                break;
-
-            while (order_ptr->display > 0 && !level.empty())
-            {
-                Order *passive = level.front();
-                if (order_ptr->ownerID == passive->ownerID)
-                {
-                    level.pop_front();
-                    cancel_order(passive->id);
-                    continue;
-                }
-
-                Quantity match_qty = min(order_ptr->display, passive->display);
-                trades.push_back(execute_trade(order_ptr, passive, match_qty));
-
-                order_ptr->display -= match_qty;
-                passive->display -= match_qty;
-                passive->remaining -= match_qty;
+        report.status = ExecStatus::REJECTED_NO_MEMORY;
+        return report;
+    }
+    order_ptr->id = id;
+    order_ptr->side = side;
+    order_ptr->type = type;
+    order_ptr->ownerID = ownerID;
+    order_ptr->display = static_cast<int32_t>(disp);
+    order_ptr->remaining = static_cast<int32_t>(qty);
+
+    OrderCold &cold = order_pool_.cold(order_ptr);
+    cold.price = screen.price;
+    cold.stop_price = screen.stop_price;
+    cold.quantity = qty;
+    cold.display_size = display_size;
+    cold.session_id = session_id;
+    cold.timestamp = message_time_;
 
-                if (passive->display == 0)
-                {
-                    level.pop_front();
-                    bool order_refilled = handle_iceberg_refill(passive, level);
-                    if (!order_refilled)
-                    {
-                        orders_.erase(passive->id);
-                        order_pool_.release(passive);
-                    }
-                }
-            }
-            cleanup_empty_level(opposite, best_price);
-        }
+    {
+        STAGE_TIMER(stage_timers_.risk);
+        ENGINE_PROBE(risk_begin, id);
+        report.risk_result = risk_manager_.check_order(*order_ptr, cold);
+        ENGINE_PROBE(risk_end, static_cast<uint64_t>(report.risk_result));
     }
-    else
+    if (report.risk_result != RiskManager::RiskResult::APPROVED)
     {
-        auto &opposite = bids_;
-        while (order_ptr->display > 0 && !opposite.empty())
-        {
-            auto &[best_price, level] = *opposite.begin();
-            if (price > best_price)
-                break;
+        release_order(order_ptr);
+        count_risk_reject(report.risk_result);
+        report.status = ExecStatus::REJECTED_RISK;
+        return report;
+    }
 
-            while (order_ptr->display > 0 && !level.empty())
-            {
-                Order *passive = level.front();
-                if (order_ptr->ownerID == passive->ownerID)
-                {
-                    level.pop_front();
-                    cancel_order(passive->id);
-                    continue;
-                }
+    if (type == OrderType::STOP_LOSS)
+    {
+        cold.stop_slot = stop_manager_.add_stop_order(order_ptr, cold.stop_price);
+        index_order(order_ptr);
+        report.status = ExecStatus::STOP_PENDING;
+        end_message();
+        return report;
+    }
 
-                Quantity match_qty = min(order_ptr->display, passive->display);
-                trades.push_back(execute_trade(order_ptr, passive, match_qty));
+    Quantity initial_remaining = order_ptr->remaining;
+    Price limit_price = cold.price;
+    Price trigger_price = 0;
 
-                order_ptr->display -= match_qty;
-                passive->display -= match_qty;
-                passive->remaining -= match_qty;
+    match_order(order_ptr, limit_price, sink);
 
-                if (passive->display == 0)
-                {
-                    level.pop_front();
-                    bool order_refilled = handle_iceberg_refill(passive, level);
-                    if (!order_refilled)
-                    {
-                        orders_.erase(passive->id);
-                        order_pool_.release(passive);
-                    }
-                }
-            }
-            cleanup_empty_level(opposite, best_price);
-        }
+    report.filled_quantity = initial_remaining - order_ptr->remaining;
+    if (report.filled_quantity > 0)
+    {
+        trigger_price = last_trade_price_;
     }
 
     // Add remaining to book if GTC or ICEBERG
     if (order_ptr->display > 0 && (type == OrderType::GTC || type == OrderType::ICEBERG))
     {
-        if (side == Side::BUY)
-        {
-            bids_[price].add_order(order_ptr);
-        }
-        else
-        {
-            asks_[price].add_order(order_ptr);
-        }
-        orders_[id] = order_ptr;
+        report.leaves_quantity = order_ptr->remaining;
+        report.status = report.filled_quantity > 0 ? ExecStatus::PARTIALLY_FILLED : ExecStatus::RESTING;
+        rest_order(order_ptr, limit_price);
+        index_order(order_ptr);
     }
     else
     {
-        order_pool_.release(order_ptr);
+        report.status = order_ptr->remaining == 0 ? ExecStatus::FILLED : ExecStatus::CANCELLED;
+        release_order(order_ptr);
     }
 
-    process_triggered_stops(trades);
+    process_triggered_stops(sink, trigger_price);
+    finish_report(report, trades_before, stops_before);
+    return report;
+}
 
-    stats_.totalTrades += trades.size();
-    for (auto &trade : trades)
+void OrderBook::match_order(Order *order, Price limit_price, TradeSink sink)
+{
+    STAGE_TIMER(stage_timers_.match);
+    ENGINE_PROBE(match_begin, order->id);
+    bool buy = order->side == Side::BUY;
+    switch (order->type)
     {
-        stats_.totalVolumes += trade.quantity;
+    case OrderType::MARKET:
+        buy ? match_kernel<Side::BUY, MarketMatch>(order, limit_price, sink)
+            : match_kernel<Side::SELL, MarketMatch>(order, limit_price, sink);
+        break;
+    case OrderType::FOK:
+        buy ? match_kernel<Side::BUY, FillOrKillMatch>(order, limit_price, sink)
+            : match_kernel<Side::SELL, FillOrKillMatch>(order, limit_price, sink);
+        break;
+    case OrderType::AON_IOC:
+        buy ? match_kernel<Side::BUY, AllOrNoneMatch>(order, limit_price, sink)
+            : match_kernel<Side::SELL, AllOrNoneMatch>(order, limit_price, sink);
+        break;
+    case OrderType::ICEBERG:
+        // Trading the whole display brings out the next slice of the reserve,
+        // which crosses on until it rests or the order is used up
+        for (;;)
+        {
+            buy ? match_kernel<Side::BUY, LimitMatch>(order, limit_price, sink)
+                : match_kernel<Side::SELL, LimitMatch>(order, limit_price, sink);
+            if (order->display > 0 || order->remaining <= 0)
+                break;
+            order->display = static_cast<int32_t>(min<Quantity>(order->remaining, order_pool_.cold(order).display_size));
+        }
+        break;
+    default:
+        buy ? match_kernel<Side::BUY, LimitMatch>(order, limit_price, sink)
+            : match_kernel<Side::SELL, LimitMatch>(order, limit_price, sink);
+        break;
     }
-    return trades;
+    ENGINE_PROBE(match_end, order->id);
 }
 
-void OrderBook::process_triggered_stops(vector<Trade> &trades)
+// The one matching loop. Resting orders are visited in price-time order,
+// market makers first at each level; the aggressor's own orders on the
+// way are cancelled (self-trade prevention), or stepped over for SKIP_OWN,
+// and never traded against.
+template <Side S, typename Type>
+void OrderBook::match_kernel(Order *order, Price limit_price, TradeSink &sink)
 {
-    if (trades.empty())
-        return;
-
-    Price last_trade_price = trades.back().price;
+    auto &contra = contra_ladder<S>();
+    if constexpr (Type::ALL_OR_NONE)
+    {
+        // Level totals first: necessary for a full fill, and no resting
+        // order is read when they fall short
+        if (!contra.covers(limit_price, order->display) || !aon_fillable(order, limit_price))
+            return;
+    }
 
-    if (stop_cascade_depth_ >= MAX_CASCADE_DEPTH)
+    Price price = contra.best_price();
+    PriceLevel *level = contra.best_level();
+    while (order->display > 0 && level != nullptr)
     {
-        return;
+        if constexpr (Type::LIMITED)
+        {
+            if (!MatchSide<S>::crosses(limit_price, price))
+                break;
+        }
+        note_level(MatchSide<S>::CONTRA, price);
+        if constexpr (Type::SKIP_OWN)
+        {
+            // Own orders stay, so the level may outlive the sweep: step past it
+            sweep_past_own(order, *level, price, sink);
+            Price swept = price;
+            price = contra.next_price(swept);
+            level = price != 0 ? contra.find(price) : nullptr;
+            contra.remove_if_empty(swept);
+        }
+        else
+        {
+            sweep_level(order, *level, price, sink);
+            contra.remove_if_empty(price);
+            price = contra.best_price();
+            level = contra.best_level();
+        }
     }
+}
+
+void OrderBook::process_triggered_stops(TradeSink sink, Price last_trade_price)
+{
+    // One pass per inbound message: a triggered stop's own fills do not
+    // re-check the stops, so cascades never go past one level
+    if (last_trade_price <= 0)
+        return;
 
+    STAGE_TIMER(stage_timers_.stops);
     auto triggered_stops = stop_manager_.check_triggered_stops(last_trade_price);
 
     for (Order *stop_order : triggered_stops)
     {
-        if (processing_stops_.count(stop_order->id))
+        if (stop_order->is_triggered)
         {
             continue;
         }
 
-        processing_stops_.insert(stop_order->id);
-        stop_cascade_depth_++;
         stats_.totalStopTriggered++;
 
         stop_order->type = OrderType::MARKET;
-        stop_order->price = 0;
         stop_order->is_triggered = true;
+        journal(L3EventType::STOP_TRIGGER, stop_order, order_pool_.cold(stop_order).stop_price, stop_order->display, 0);
 
-        vector<Trade> stop_trades;
-        add_market_order(stop_order, stop_trades);
-        trades.insert(trades.end(), stop_trades.begin(), stop_trades.end());
-
-        orders_.erase(stop_order->id);
-        order_pool_.release(stop_order);
+        match_order(stop_order, 0, sink);
 
-        processing_stops_.erase(stop_order->id);
-        stop_cascade_depth_--;
+        retire_order(stop_order);
     }
 }
 
-void OrderBook::add_market_order(Order *order, vector<Trade> &trades)
+void OrderBook::sweep_level(Order *order, PriceLevel &level, Price price, TradeSink &sink)
 {
-    if (order->side == Side::BUY)
+    QueueChunk chunk;
+    while (order->display > 0 && !level.empty())
     {
-        auto &opposite = asks_;
-        while (order->display > 0 && !opposite.empty())
+        // Market-maker queue first, as front() orders them; a refilled
+        // iceberg goes to the back of its own queue, behind this chunk
+        OrderQueue &queue = level.mm_orders.empty() ? level.regular_orders : level.mm_orders;
+        chunk.gather(order_pool_, queue, order->ownerID, order->display);
+        size_t reached = chunk.reach(order->display);
+
+        // Everything reached is used up except, possibly, the last order
+        bool partial = chunk.total[reached - 1] > order->display;
+        size_t consumed = reached - (partial ? 1 : 0);
+        if (consumed > 0)
         {
-            auto &[best_price, level] = *opposite.begin();
+            level.detach_front(order_pool_, queue, chunk, consumed);
+        }
 
-            while (order->display > 0 && !level.empty())
+        for (size_t i = 0; i < consumed; i++)
+        {
+            Order *passive = order_pool_.at(chunk.slot[i]);
+            if (chunk.owner[i] == order->ownerID)
             {
-                Order *passive = level.front();
-                if (order->ownerID == passive->ownerID)
-                {
-                    level.pop_front();
-                    orders_.erase(passive->id);
-                    order_pool_.release(passive);
-                    continue;
-                }
+                journal(L3EventType::CANCEL, passive, price, passive->display, 0, 0, L3CancelReason::SELF_TRADE);
+                retire_order(passive);
+                stats_.totalCancelledOrders++;
+                continue;
+            }
 
-                Quantity cur_quant = min(passive->display, order->display);
-                trades.push_back(execute_trade(order, passive, cur_quant));
+            Quantity cur_quant = chunk.quantity[i];
+            emit_trade(sink, execute_trade(order, passive, cur_quant, price));
 
-                passive->display -= cur_quant;
-                passive->remaining -= cur_quant;
-                order->display -= cur_quant;
+            passive->display = 0;
+            passive->remaining -= static_cast<int32_t>(cur_quant);
+            order->display -= cur_quant;
+            order->remaining -= static_cast<int32_t>(cur_quant);
+            journal(L3EventType::EXECUTE, passive, price, static_cast<int32_t>(cur_quant), 0, order->id);
 
-                if (passive->display == 0)
-                {
-                    level.pop_front();
-                    bool order_refilled = handle_iceberg_refill(passive, level);
-                    if (!order_refilled)
-                    {
-                        orders_.erase(passive->id);
-                        order_pool_.release(passive);
-                    }
-                }
+            if (!handle_iceberg_refill(passive, level))
+            {
+                retire_order(passive);
             }
-            cleanup_empty_level(opposite, best_price);
+        }
+
+        if (partial)
+        {
+            Order *passive = order_pool_.at(chunk.slot[consumed]);
+            Quantity cur_quant = order->display;
+            emit_trade(sink, execute_trade(order, passive, cur_quant, price));
+
+            level.reduce(passive, cur_quant);
+            order->remaining -= static_cast<int32_t>(cur_quant);
+            order->display = 0;
+            journal(L3EventType::EXECUTE, passive, price, static_cast<int32_t>(cur_quant), passive->display, order->id);
         }
     }
-    else
+}
+
+void OrderBook::sweep_past_own(Order *order, PriceLevel &level, Price price, TradeSink &sink)
+{
+    // A refilled iceberg rejoins the back of its queue and may be reached again
+    auto sweep_queue = [&](OrderQueue &queue)
     {
-        auto &opposite = bids_;
-        while (order->display > 0 && !opposite.empty())
+        for (uint32_t slot = queue.head; slot != NO_ORDER_SLOT && order->display > 0;)
         {
-            auto &[best_price, level] = *opposite.begin();
+            Order *passive = order_pool_.at(slot);
+            slot = passive->next;
+            if (passive->ownerID == order->ownerID)
+                continue;
+
+            Quantity cur_quant = min<Quantity>(order->display, passive->display);
+            emit_trade(sink, execute_trade(order, passive, cur_quant, price));
 
-            while (order->display > 0 && !level.empty())
+            level.reduce(passive, cur_quant);
+            order->display -= static_cast<int32_t>(cur_quant);
+            order->remaining -= static_cast<int32_t>(cur_quant);
+            journal(L3EventType::EXECUTE, passive, price, static_cast<int32_t>(cur_quant), passive->display, order->id);
+
+            if (passive->display == 0)
             {
-                Order *passive = level.front();
-                if (order->ownerID == passive->ownerID)
+                level.erase(order_pool_, passive);
+                if (!handle_iceberg_refill(passive, level))
                 {
-                    level.pop_front();
-                    orders_.erase(passive->id);
-                    order_pool_.release(passive);
-                    continue;
+                    retire_order(passive);
                 }
-
-                Quantity cur_quant = min(passive->display, order->display);
-                trades.push_back(execute_trade(order, passive, cur_quant));
-
-                passive->display -= cur_quant;
-                passive->remaining -= cur_quant;
-                order->display -= cur_quant;
-
-                if (passive->display == 0)
+                else if (slot == NO_ORDER_SLOT)
                 {
-                    level.pop_front();
-                    bool order_refilled = handle_iceberg_refill(passive, level);
-                    if (!order_refilled)
-                    {
-                        orders_.erase(passive->id);
-                        order_pool_.release(passive);
-                    }
+                    slot = order_pool_.slot(passive);
                 }
             }
-            cleanup_empty_level(opposite, best_price);
         }
-    }
+    };
+    sweep_queue(level.mm_orders);
+    sweep_queue(level.regular_orders);
 }
 
-bool OrderBook::add_FOK_order(Order *order, vector<Trade> &trades)
+bool OrderBook::aon_fillable(const Order *order, Price limit_price)
 {
-    Quantity needed = order->quantity;
-    vector<pair<Order *, Quantity>> candidates;
-
-    auto check_orders = [&](const deque<Order *> orders)
+    // Own orders do not count, so this walks the queues
+    Quantity needed = order->display;
+    auto count_queue = [&](const OrderQueue &orders)
     {
-        for (Order *passive : orders)
+        for (uint32_t slot = orders.head; slot != NO_ORDER_SLOT && needed > 0;)
         {
-            if (order->ownerID == passive->ownerID)
-                continue;
-
-            Quantity available = min(needed, passive->display);
-            candidates.emplace_back(passive, available);
-            needed -= available;
-
-            if (needed <= 0)
-                return true;
+            const Order *passive = order_pool_.at(slot);
+            slot = passive->next;
+            if (passive->ownerID != order->ownerID)
+            {
+                needed -= passive->display;
+            }
         }
-        return false;
     };
+    auto count_level = [&](Price price, PriceLevel &level)
+    {
+        if (order->side == Side::BUY ? price > limit_price : price < limit_price)
+            return false;
+        count_queue(level.mm_orders);
+        count_queue(level.regular_orders);
+        return needed > 0;
+    };
+    if (order->side == Side::BUY)
+    {
+        asks_.for_each_level(count_level);
+    }
+    else
+    {
+        bids_.for_each_level(count_level);
+    }
+    return needed <= 0;
+}
 
-    // Check if we can fill completely
+void OrderBook::rest_order(Order *order, Price price)
+{
+    note_level(order->side, price);
     if (order->side == Side::BUY)
     {
-        for (auto &[price_level, level] : asks_)
-        {
-            if (price_level > order->price)
-                break;
+        bids_.get_or_create(price).add_order(order_pool_, order);
+    }
+    else
+    {
+        asks_.get_or_create(price).add_order(order_pool_, order);
+    }
+    journal(L3EventType::ADD, order, price, order->display, order->display);
+}
 
-            if (!check_orders(level.mm_orders) && needed > 0)
-            {
-                check_orders(level.regular_orders);
-            }
-            if (needed <= 0)
-                break;
+void OrderBook::cancel_live_order(Order *order)
+{
+    const OrderCold &cold = order_pool_.cold(order);
+
+    if (order->type == OrderType::STOP_LOSS)
+    {
+        stop_manager_.remove_stop_order(order, cold.stop_slot);
+    }
+    else if (order->side == Side::BUY)
+    {
+        if (PriceLevel *level = bids_.find(cold.price))
+        {
+            note_level(Side::BUY, cold.price);
+            level->erase(order_pool_, order);
+            journal(L3EventType::CANCEL, order, cold.price, order->display, 0, 0, L3CancelReason::USER);
+            bids_.remove_if_empty(cold.price);
         }
     }
     else
     {
-        for (auto &[price_level, level] : bids_)
+        if (PriceLevel *level = asks_.find(cold.price))
         {
-            if (price_level < order->price)
-                break;
-
-            if (!check_orders(level.mm_orders) && needed > 0)
-            {
-                check_orders(level.regular_orders);
-            }
-            if (needed <= 0)
-                break;
+            note_level(Side::SELL, cold.price);
+            level->erase(order_pool_, order);
+            journal(L3EventType::CANCEL, order, cold.price, order->display, 0, 0, L3CancelReason::USER);
+            asks_.remove_if_empty(cold.price);
         }
     }
 
-    if (needed > 0)
-        return false; // Cannot fill completely
+    retire_order(order);
+    stats_.totalCancelledOrders++;
+}
+
+bool OrderBook::cancel_order(OrderId id)
+{
+    message_time_ = clock_.message_time();
+    Order **order = orders_.find(id);
+    if (order == nullptr)
+        return false;
 
-    // Execute all trades
-    for (auto &[passive, qty] : candidates)
+    cancel_live_order(*order);
+    end_message();
+    return true;
+}
+
+ExecutionReport OrderBook::submit_modify(OrderId id, Price new_price, Quantity new_quantity, TradeSink sink)
+{
+    message_time_ = clock_.message_time();
+    ExecutionReport report{};
+    uint64_t trades_before = stats_.totalTrades;
+    uint64_t stops_before = stats_.totalStopTriggered;
+
+    Order **indexed = orders_.find(id);
+    Order *order = indexed ? *indexed : nullptr;
+    PriceLevel *level = nullptr;
+    if (order && (order->type == OrderType::GTC || order->type == OrderType::ICEBERG))
     {
-        trades.push_back(execute_trade(order, passive, qty));
+        Price price = order_pool_.cold(order).price;
+        level = order->side == Side::BUY ? bids_.find(price) : asks_.find(price);
+    }
+    if (level == nullptr)
+    {
+        report.status = ExecStatus::REJECTED_UNKNOWN;
+        return report;
+    }
+    OrderCold &cold = order_pool_.cold(order);
 
-        passive->display -= qty;
-        passive->remaining -= qty;
-        order->display -= qty;
-        order->remaining -= qty;
+    if (new_quantity <= 0 || new_quantity > MAX_ORDER_QUANTITY || new_price <= 0)
+    {
+        report.risk_result = RiskManager::RiskResult::REJECTED_ORDER_SIZE;
+        count_risk_reject(report.risk_result);
+        report.status = ExecStatus::REJECTED_RISK;
+        return report;
+    }
+    Price rounded_price = tick_table_.round_to_tick(new_price);
+    if (rounded_price <= 0)
+    {
+        report.risk_result = RiskManager::RiskResult::REJECTED_INVALID_TICK_SIZE;
+        count_risk_reject(report.risk_result);
+        report.status = ExecStatus::REJECTED_RISK;
+        return report;
+    }
+    new_price = rounded_price;
+
+    Price old_price = cold.price;
+    Quantity old_quantity = order->remaining;
 
-        if (passive->display == 0)
+    // Size-down in place: the order keeps its queue position
+    if (new_price == old_price && new_quantity <= old_quantity)
+    {
+        if (new_quantity < old_quantity)
         {
-            auto &level = (passive->side == Side::BUY) ? bids_[passive->price] : asks_[passive->price];
-            level.erase(passive);
+            int32_t cut = max<int32_t>(order->display - static_cast<int32_t>(new_quantity), 0);
+            note_level(order->side, old_price);
+            level->reduce(order, cut);
+            order->remaining = static_cast<int32_t>(new_quantity);
+            journal(L3EventType::REDUCE, order, old_price, cut, order->display);
+        }
+        stats_.totalModifiedOrders++;
+        report.status = ExecStatus::RESTING;
+        report.leaves_quantity = order->remaining;
+        finish_report(report, trades_before, stops_before);
+        return report;
+    }
 
-            bool order_refilled = handle_iceberg_refill(passive, level);
-            if (!order_refilled)
-            {
-                orders_.erase(passive->id);
-                order_pool_.release(passive);
-            }
+    {
+        STAGE_TIMER(stage_timers_.risk);
+        ENGINE_PROBE(risk_begin, id);
+        report.risk_result = risk_manager_.check_modify(*order, old_price, old_quantity, new_price, new_quantity,
+                                                        message_time_);
+        ENGINE_PROBE(risk_end, static_cast<uint64_t>(report.risk_result));
+    }
+    if (report.risk_result != RiskManager::RiskResult::APPROVED)
+    {
+        count_risk_reject(report.risk_result);
+        report.status = ExecStatus::REJECTED_RISK;
+        return report;
+    }
 
-            if (level.empty())
-            {
-                if (passive->side == Side::BUY)
-                {
-                    bids_.erase(passive->price);
-                }
-                else
-                {
-                    asks_.erase(passive->price);
-                }
-            }
+    stats_.totalModifiedOrders++;
+
+    // Off the old level, keeping the slot and the index entry
+    note_level(order->side, old_price);
+    level->erase(order_pool_, order);
+    journal(L3EventType::CANCEL, order, old_price, order->display, 0, 0, L3CancelReason::REPLACED);
+    if (order->side == Side::BUY)
+    {
+        bids_.remove_if_empty(old_price);
+    }
+    else
+    {
+        asks_.remove_if_empty(old_price);
+    }
+
+    cold.price = new_price;
+    cold.quantity = new_quantity;
+    cold.timestamp = message_time_;
+    order->remaining = static_cast<int32_t>(new_quantity);
+    order->display = order->type == OrderType::ICEBERG
+                         ? static_cast<int32_t>(min<Quantity>(new_quantity, cold.display_size))
+                         : static_cast<int32_t>(new_quantity);
+
+    match_order(order, new_price, sink);
+    report.filled_quantity = static_cast<Quantity>(new_quantity) - order->remaining;
+    Price trigger_price = report.filled_quantity > 0 ? last_trade_price_ : 0;
+
+    if (order->display > 0)
+    {
+        report.leaves_quantity = order->remaining;
+        report.status = report.filled_quantity > 0 ? ExecStatus::PARTIALLY_FILLED : ExecStatus::RESTING;
+        rest_order(order, new_price);
+    }
+    else
+    {
+        report.status = ExecStatus::FILLED;
+        retire_order(order);
+    }
+
+    process_triggered_stops(sink, trigger_price);
+    finish_report(report, trades_before, stops_before);
+    return report;
+}
+
+template <typename Match>
+size_t OrderBook::mass_cancel(uint32_t owner, Match &&match)
+{
+    const OwnerOrders *list = owner_orders_.find(owner);
+    if (list == nullptr)
+        return 0;
+
+    message_time_ = clock_.message_time();
+    size_t cancelled = 0;
+    for (uint32_t slot = list->head; slot != NO_ORDER_SLOT;)
+    {
+        Order *order = order_pool_.at(slot);
+        slot = order_pool_.cold(order).owner_next;
+        if (match(order))
+        {
+            cancel_live_order(order);
+            cancelled++;
         }
     }
-    return true;
+    end_message();
+    return cancelled;
 }
 
-bool OrderBook::cancel_order(OrderId id)
+size_t OrderBook::cancel_all_orders(uint32_t owner)
 {
-    auto it = orders_.find(id);
-    if (it == orders_.end())
-        return false;
+    return mass_cancel(owner, [](const Order *)
+                       { return true; });
+}
 
-    Order *order = it->second;
+size_t OrderBook::cancel_session_orders(uint32_t owner, uint32_t session_id)
+{
+    return mass_cancel(owner, [&](const Order *order)
+                       { return order_pool_.cold(order).session_id == session_id; });
+}
 
-    if (order->type == OrderType::STOP_LOSS)
+size_t OrderBook::cancel_side_orders(uint32_t owner, Side side)
+{
+    return mass_cancel(owner, [side](const Order *order)
+                       { return order->side == side; });
+}
+
+BatchReport OrderBook::submit_quotes(uint32_t owner, uint32_t session_id, const QuoteUpdate *quotes,
+                                     size_t count, TradeSink sink)
+{
+    message_time_ = clock_.message_time();
+    BatchReport report{};
+    if (session_rejected(session_id))
     {
-        stop_manager_.remove_stop_order(id);
+        report.status = ExecStatus::REJECTED_SESSION;
+        return report;
     }
-    else
+    report.status = ExecStatus::RESTING;
+    uint64_t trades_before = stats_.totalTrades;
+    uint64_t stops_before = stats_.totalStopTriggered;
+
+    // Screen everything before touching the book, so a reject changes nothing
+    quote_batch_.assign(quotes, quotes + count);
+    quote_replaced_.clear();
+    size_t new_orders = 0;
+    for (QuoteUpdate &quote : quote_batch_)
     {
-
-        if (order->side == Side::BUY)
+        if (quote.replaces_id != 0)
         {
-            auto price_it = bids_.find(order->price);
-            if (price_it != bids_.end())
+            // An order named twice in one batch is cancelled once
+            Order **replaced = orders_.find(quote.replaces_id);
+            if (replaced && (*replaced)->ownerID == owner &&
+                find(quote_replaced_.begin(), quote_replaced_.end(), *replaced) == quote_replaced_.end())
             {
-                auto &level = price_it->second;
-                level.erase(order);
-                if (level.empty())
-                {
-                    bids_.erase(price_it);
-                }
+                quote_replaced_.push_back(*replaced);
             }
         }
+        if (quote.id == 0)
+            continue;
+        if (quote.quantity <= 0 || quote.quantity > MAX_ORDER_QUANTITY || quote.price <= 0)
+        {
+            report.risk_result = RiskManager::RiskResult::REJECTED_ORDER_SIZE;
+            break;
+        }
+        Price rounded_price = tick_table_.round_to_tick(quote.price);
+        if (rounded_price <= 0)
+        {
+            report.risk_result = RiskManager::RiskResult::REJECTED_INVALID_TICK_SIZE;
+            break;
+        }
+        quote.price = rounded_price;
+        new_orders++;
+    }
+
+    if (report.risk_result == RiskManager::RiskResult::APPROVED)
+    {
+        STAGE_TIMER(stage_timers_.risk);
+        ENGINE_PROBE(risk_begin, owner);
+        report.risk_result = risk_manager_.check_quotes(owner, message_time_, quote_batch_.data(), quote_batch_.size());
+        ENGINE_PROBE(risk_end, static_cast<uint64_t>(report.risk_result));
+    }
+    if (report.risk_result != RiskManager::RiskResult::APPROVED)
+    {
+        count_risk_reject(report.risk_result);
+        report.status = ExecStatus::REJECTED_RISK;
+        return report;
+    }
+    if (new_orders > quote_replaced_.size() && !order_pool_.reserve(new_orders - quote_replaced_.size()))
+    {
+        report.status = ExecStatus::REJECTED_NO_MEMORY;
+        return report;
+    }
+
+    for (Order *order : quote_replaced_)
+    {
+        cancel_live_order(order);
+    }
+    report.cancelled = static_cast<uint32_t>(quote_replaced_.size());
+
+    for (const QuoteUpdate &quote : quote_batch_)
+    {
+        if (quote.id == 0)
+            continue;
+
+        stats_.totalOrders++;
+        Order *order = acquire_order();
+        order->id = quote.id;
+        order->side = quote.side;
+        order->type = OrderType::GTC;
+        order->ownerID = owner;
+        order->display = static_cast<int32_t>(quote.quantity);
+        order->remaining = static_cast<int32_t>(quote.quantity);
+
+        OrderCold &cold = order_pool_.cold(order);
+        cold.price = quote.price;
+        cold.quantity = quote.quantity;
+        cold.display_size = quote.quantity;
+        cold.session_id = session_id;
+        cold.timestamp = message_time_;
+
+        match_order(order, quote.price, sink);
+        report.filled_quantity += quote.quantity - order->display;
+        if (order->display > 0)
+        {
+            rest_order(order, quote.price);
+            index_order(order);
+            report.resting++;
+        }
         else
         {
-            auto price_it = asks_.find(order->price);
-            if (price_it != asks_.end())
+            release_order(order);
+        }
+    }
+
+    process_triggered_stops(sink, stats_.totalTrades > trades_before ? last_trade_price_ : 0);
+    report.trade_count = static_cast<uint32_t>(stats_.totalTrades - trades_before);
+    report.stops_triggered = static_cast<uint32_t>(stats_.totalStopTriggered - stops_before);
+    end_message();
+    return report;
+}
+
+void OrderBook::publish_l2()
+{
+    if (l2_touched_.empty())
+        return;
+
+    // A level touched twice keeps its state from before the first touch
+    auto by_level = [](const L2Touch &a, const L2Touch &b)
+    {
+        return a.side != b.side ? a.side < b.side : a.price < b.price;
+    };
+    if (l2_touched_.size() > 1)
+    {
+        stable_sort(l2_touched_.begin(), l2_touched_.end(), by_level);
+    }
+
+    l2_deltas_.clear();
+    for (size_t i = 0; i < l2_touched_.size(); i++)
+    {
+        const L2Touch &before = l2_touched_[i];
+        if (i > 0 && !by_level(l2_touched_[i - 1], before))
+            continue;
+
+        const PriceLevel *level = before.side == Side::BUY ? bids_.find(before.price) : asks_.find(before.price);
+        if (level == nullptr)
+        {
+            if (before.existed)
             {
-                auto &level = price_it->second;
-                level.erase(order);
-                if (level.empty())
-                {
-                    asks_.erase(price_it);
-                }
+                l2_deltas_.push_back(L2Delta{before.price, 0, 0, before.side, L2Action::DELETE});
             }
         }
+        else if (!before.existed)
+        {
+            l2_deltas_.push_back(L2Delta{before.price, level->visible_quantity, level->order_count, before.side, L2Action::ADD});
+        }
+        else if (level->visible_quantity != before.quantity || level->order_count != before.order_count)
+        {
+            l2_deltas_.push_back(L2Delta{before.price, level->visible_quantity, level->order_count, before.side, L2Action::CHANGE});
+        }
     }
+    l2_touched_.clear();
 
-    orders_.erase(it);
-    order_pool_.release(order);
-    stats_.totalCancelledOrders++;
-    return true;
+    if (!l2_deltas_.empty())
+    {
+        l2_sink_(L2Update{++l2_sequence_, l2_deltas_.data(), l2_deltas_.data() + l2_deltas_.size()});
+    }
+}
+
+size_t OrderBook::get_depth(Side side, size_t max_levels, vector<L2Level> &out)
+{
+    out.clear();
+    if (max_levels == 0)
+        return 0;
+
+    auto collect = [&](Price price, PriceLevel &level)
+    {
+        out.push_back(L2Level{price, level.visible_quantity, level.order_count});
+        return out.size() < max_levels;
+    };
+    if (side == Side::BUY)
+    {
+        bids_.for_each_level(collect);
+    }
+    else
+    {
+        asks_.for_each_level(collect);
+    }
+    return out.size();
 }
\ No newline at end of file
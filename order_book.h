@@ -1,103 +1,292 @@
 #pragma once
 #include "types.h"
-#include "object_pool.h"
+#include "order_store.h"
 #include "risk_manager.h"
 #include "stop_manager.h"
 #include "tick_table.h"
 #include "session_management.h"
+#include "price_ladder.h"
+#include "trade_sink.h"
+#include "clock.h"
+#include "latency_histogram.h"
+#include "market_depth.h"
+#include "l3_journal.h"
+#include "flat_index.h"
+#include "telemetry.h"
 
-struct PriceLevel
+enum class ExecStatus
 {
-    deque<Order *> mm_orders;
-    deque<Order *> regular_orders;
+    RESTING,            // accepted, nothing filled, resting on the book
+    PARTIALLY_FILLED,   // some quantity traded, the rest is resting
+    FILLED,             // fully executed
+    CANCELLED,          // unfilled quantity dropped (IOC, MARKET, FOK that could not fill)
+    STOP_PENDING,       // stop order parked until triggered
+    REJECTED_RISK,      // see risk_result
+    REJECTED_NO_MEMORY, // order store full
+    REJECTED_UNKNOWN,   // modify of an order that is not resting on the book
+    REJECTED_SESSION,   // validate_sessions: session unknown or not authenticated
+};
+
+struct ExecutionReport
+{
+    ExecStatus status;
+    RiskManager::RiskResult risk_result;
+    Quantity filled_quantity;  // traded by the inbound order itself
+    Quantity leaves_quantity;  // quantity left resting, an iceberg's reserve included
+    uint32_t trade_count;      // trades emitted, including triggered stops
+    uint32_t stops_triggered;
+};
+
+// Outcome of a replace_quotes batch. A rejected batch changes nothing;
+// otherwise every cancel and quote was applied.
+struct BatchReport
+{
+    ExecStatus status; // REJECTED_RISK, REJECTED_NO_MEMORY, REJECTED_SESSION or RESTING
+    RiskManager::RiskResult risk_result;
+    uint32_t cancelled;       // replaced orders that were still live
+    uint32_t resting;         // quotes left on the book
+    Quantity filled_quantity; // traded by the batch's quotes
+    uint32_t trade_count;     // trades emitted, including triggered stops
+    uint32_t stops_triggered;
+};
+
+// Result of OrderBook::screen_order: the static risk verdict and the
+// order's prices snapped to the tick grid
+struct ScreenedOrder
+{
+    RiskManager::RiskResult risk_result;
+    Price price;
+    Price stop_price;
+};
 
-    Order *front()
+struct OrderBookConfig
+{
+    size_t order_pool_size = 2000000;
+    size_t order_pool_limit = 0; // hot expansion ceiling in orders, 0 = fixed at order_pool_size
+    ArenaConfig arena;            // pages and NUMA node of the order store
+    size_t order_index_reserve = 500000;
+    size_t trade_buffer_capacity = 1000;
+    LadderConfig ladder;
+    ClockConfig clock;
+    bool validate_sessions = false; // orders with a session id need a live, authenticated session
+};
+
+// Compile-time parameters of OrderBook::match_kernel. The side fixes the
+// ladder crossed and which way the limit compares; the order type whether
+// there is a limit and whether the fill must be complete before any trade.
+template <Side S>
+struct MatchSide
+{
+    static constexpr Side CONTRA = S == Side::BUY ? Side::SELL : Side::BUY;
+
+    // The limit reaches a resting price on the contra side
+    static bool crosses(Price limit_price, Price resting_price)
     {
-        if (!mm_orders.empty())
-        {
-            return mm_orders.front();
-        }
-        else
-        {
-            return regular_orders.front();
-        }
-        return nullptr;
+        return S == Side::BUY ? resting_price <= limit_price : resting_price >= limit_price;
     }
+};
+
+// SKIP_OWN leaves the aggressor's own resting orders where they are
+// instead of cancelling them on contact
+struct MarketMatch // MARKET and triggered stops
+{
+    static constexpr bool LIMITED = false;
+    static constexpr bool ALL_OR_NONE = false;
+    static constexpr bool SKIP_OWN = false;
+};
+
+struct LimitMatch // GTC, IOC, ICEBERG, quotes and repriced orders
+{
+    static constexpr bool LIMITED = true;
+    static constexpr bool ALL_OR_NONE = false;
+    static constexpr bool SKIP_OWN = false;
+};
+
+struct FillOrKillMatch // FOK
+{
+    static constexpr bool LIMITED = true;
+    static constexpr bool ALL_OR_NONE = true;
+    static constexpr bool SKIP_OWN = true;
+};
+
+struct AllOrNoneMatch // AON_IOC
+{
+    static constexpr bool LIMITED = true;
+    static constexpr bool ALL_OR_NONE = true;
+    static constexpr bool SKIP_OWN = false;
+};
 
-    void pop_front()
+class OrderBook
+{
+private:
+    TickSizeTable tick_table_;
+    PriceLadder<Side::BUY> bids_;
+    PriceLadder<Side::SELL> asks_;
+    FlatIndex<OrderId, Order *> orders_;
+    OrderStore order_pool_;
+    TradeBuffer trade_buffer_;
+
+    Price last_trade_price_;
+    EngineClock clock_;
+    int64_t message_time_; // clock_ read once for the message being processed
+
+    RiskManager risk_manager_;
+    StopOrderManager stop_manager_;
+    SessionManager session_manager_;
+    int session_reader_; // the book's reader id in the session table, -1 when not validating
+
+    // Wait-free; the book thread passes a quiescent point at every message
+    bool session_rejected(uint32_t session_id)
     {
-        if (!mm_orders.empty())
-        {
-            mm_orders.pop_front();
-        }
-        else
-        {
-            regular_orders.pop_front();
-        }
+        if (session_reader_ < 0)
+            return false;
+        session_manager_.quiescent(session_reader_);
+        if (session_id == 0)
+            return false;
+        const Session *session = session_manager_.find_session(session_id);
+        return session == nullptr || !session->is_authenticated();
     }
 
-    void add_order(Order *order)
+    // Every live order, resting or pending stop, is also on its owner's
+    // list, threaded through the cold records, so mass cancels cost
+    // O(orders owned). Emptied lists keep their entry.
+    struct OwnerOrders
     {
-        if (order->is_market_maker)
-        {
-            mm_orders.push_back(order);
-        }
-        else
-        {
-            regular_orders.push_back(order);
-        }
+        uint32_t head = NO_ORDER_SLOT;
+        uint32_t tail = NO_ORDER_SLOT;
+    };
+    FlatIndex<uint32_t, OwnerOrders> owner_orders_;
+    vector<QuoteUpdate> quote_batch_;  // replace_quotes scratch: rounded quotes
+    vector<Order *> quote_replaced_;   // and the live orders they replace
+
+
+    // Level state when first touched by the current message
+    struct L2Touch
+    {
+        Price price;
+        int64_t quantity;
+        uint32_t order_count;
+        Side side;
+        bool existed;
+    };
+    L2Sink l2_sink_;
+    vector<L2Touch> l2_touched_;
+    vector<L2Delta> l2_deltas_;
+    uint64_t l2_sequence_;
+
+    // Called before a level changes; free when nobody subscribes
+    void note_level(Side side, Price price)
+    {
+        if (!l2_sink_)
+            return;
+        const PriceLevel *level = side == Side::BUY ? bids_.find(price) : asks_.find(price);
+        l2_touched_.push_back(L2Touch{price, level ? level->visible_quantity : 0,
+                                      level ? level->order_count : 0u, side, level != nullptr});
     }
 
-    bool empty()
+    // Turns the touched levels into deltas for the subscriber
+    void publish_l2();
+
+    L3Journal *l3_journal_;
+
+    void journal(L3EventType type, const Order *order, Price price, int32_t quantity, int32_t leaves,
+                 OrderId contra_id = 0, L3CancelReason reason = L3CancelReason::NONE)
     {
-        return mm_orders.empty() && regular_orders.empty();
+        if (l3_journal_ == nullptr)
+            return;
+        L3Event event{};
+        event.timestamp = message_time_;
+        event.order_id = order->id;
+        event.contra_id = contra_id;
+        event.price = price;
+        event.quantity = quantity;
+        event.leaves = leaves;
+        event.owner = order->ownerID;
+        event.type = type;
+        event.side = order->side;
+        event.reason = reason;
+        l3_journal_->record(event);
     }
 
-    void erase(Order *order)
+#ifdef ENGINE_STAGE_TIMERS
+    StageTimers stage_timers_;
+#endif
+
+    Order *acquire_order()
     {
-        auto it = find(mm_orders.begin(), mm_orders.end(), order);
-        if (it != mm_orders.end())
+        STAGE_TIMER(stage_timers_.pool);
+        return order_pool_.acquire();
+    }
+
+    void release_order(Order *order)
+    {
+        STAGE_TIMER(stage_timers_.pool);
+        order_pool_.release(order);
+    }
+
+    // Makes a live order findable by id and by owner
+    void index_order(Order *order)
+    {
+        orders_[order->id] = order;
+
+        uint32_t slot = order_pool_.slot(order);
+        OrderCold &cold = order_pool_.cold(order);
+        OwnerOrders &list = owner_orders_[order->ownerID];
+        cold.owner_prev = list.tail;
+        cold.owner_next = NO_ORDER_SLOT;
+        if (list.tail != NO_ORDER_SLOT)
         {
-            mm_orders.erase(it);
+            order_pool_.cold(order_pool_.at(list.tail)).owner_next = slot;
         }
         else
         {
-            it = find(regular_orders.begin(), regular_orders.end(), order);
-            if (it != regular_orders.end())
+            list.head = slot;
+        }
+        list.tail = slot;
+    }
+
+    void unlink_owner(Order *order)
+    {
+        const OrderCold &cold = order_pool_.cold(order);
+        if (cold.owner_prev == NO_ORDER_SLOT || cold.owner_next == NO_ORDER_SLOT)
+        {
+            OwnerOrders &list = owner_orders_[order->ownerID];
+            if (cold.owner_prev == NO_ORDER_SLOT)
             {
-                regular_orders.erase(it);
+                list.head = cold.owner_next;
             }
+            if (cold.owner_next == NO_ORDER_SLOT)
+            {
+                list.tail = cold.owner_prev;
+            }
+        }
+        if (cold.owner_prev != NO_ORDER_SLOT)
+        {
+            order_pool_.cold(order_pool_.at(cold.owner_prev)).owner_next = cold.owner_next;
+        }
+        if (cold.owner_next != NO_ORDER_SLOT)
+        {
+            order_pool_.cold(order_pool_.at(cold.owner_next)).owner_prev = cold.owner_prev;
         }
     }
-};
-
-class OrderBook
-{
-private:
-    map<Price, PriceLevel, greater<Price>> bids_;
-    map<Price, PriceLevel, less<Price>> asks_;
-    unordered_map<OrderId, Order *> orders_;
-    ObjectPool<Order> order_pool_;
-    ObjectPool<Trade> trade_pool_;
-    vector<Trade *> trade_buffer_;
 
-    RiskManager risk_manager_;
-    StopOrderManager stop_manager_;
-    TickSizeTable tick_table_;
-    SessionManager session_manager_;
-
-    unordered_set<OrderId> processing_stops_;
-    int stop_cascade_depth_;
-    static constexpr int MAX_CASCADE_DEPTH = 3;
+    // Drops an indexed order that has already left its level or the stops
+    void retire_order(Order *order)
+    {
+        orders_.erase(order->id);
+        unlink_owner(order);
+        release_order(order);
+    }
 
-    Trade execute_trade(Order *aggressive, Order *passive, Quantity qty)
+    // price is the passive order's level price
+    Trade execute_trade(Order *aggressive, Order *passive, Quantity qty, Price price)
     {
         Trade trade{
             aggressive->side == Side::BUY ? aggressive->id : passive->id,
             aggressive->side == Side::SELL ? aggressive->id : passive->id,
-            passive->price,
+            price,
             qty,
-            duration_cast<nanoseconds>(high_resolution_clock::now().time_since_epoch()).count()};
+            message_time_};
 
         uint32_t buyer_id = (aggressive->side == Side::BUY) ? aggressive->ownerID : passive->ownerID;
         uint32_t seller_id = (aggressive->side == Side::SELL) ? aggressive->ownerID : passive->ownerID;
@@ -108,98 +297,350 @@ private:
         return trade;
     }
 
+    void emit_trade(TradeSink &sink, const Trade &trade)
+    {
+        stats_.totalTrades++;
+        stats_.totalVolumes += trade.quantity;
+        last_trade_price_ = trade.price;
+        sink(trade);
+    }
+
+    // Written by the book's thread only, readable live from any other
     struct Stats
     {
-        uint64_t totalOrders = 0;
-        uint64_t totalTrades = 0;
-        uint64_t totalVolumes = 0;
-        uint64_t totalCancelledOrders = 0;
-        uint64_t totalIOC_rejected = 0;
-        uint64_t totalStopTriggered = 0;
-        uint64_t totalRiskRejected = 0;
+        RelaxedCounter totalOrders;
+        RelaxedCounter totalTrades;
+        RelaxedCounter totalVolumes;
+        RelaxedCounter totalCancelledOrders;
+        RelaxedCounter totalStopTriggered;
+        RelaxedCounter totalRiskRejected;
+        RelaxedCounter totalModifiedOrders;
+        array<RelaxedCounter, RiskManager::RESULT_COUNT> riskRejects;
     } stats_;
 
-    bool handle_iceberg_refill(Order *order, PriceLevel &level)
+    // Book state worth watching live, refreshed at the end of each message
+    struct Gauges
     {
-        if (order->type == OrderType::ICEBERG && order->remaining > 0)
+        RelaxedCounter poolAllocated;
+        RelaxedCounter poolCapacity;
+        RelaxedCounter bidLevels;
+        RelaxedCounter askLevels;
+        RelaxedCounter indexedOrders;
+        RelaxedCounter pendingStops;
+    } gauges_;
+
+    void count_risk_reject(RiskManager::RiskResult result)
+    {
+        stats_.totalRiskRejected++;
+        stats_.riskRejects[static_cast<size_t>(result)]++;
+    }
+
+    // Snapshot restore: the counters saved from sample_telemetry
+    void restore_counters(const TelemetryBook &counters)
+    {
+        stats_.totalOrders.set(counters.orders);
+        stats_.totalTrades.set(counters.trades);
+        stats_.totalVolumes.set(counters.volume);
+        stats_.totalCancelledOrders.set(counters.cancelled);
+        stats_.totalStopTriggered.set(counters.stops_triggered);
+        stats_.totalRiskRejected.set(counters.risk_rejected);
+        stats_.totalModifiedOrders.set(counters.modified);
+        for (size_t i = 0; i < RiskManager::RESULT_COUNT; i++)
         {
-            order->display = min(order->remaining, order->display_size);
-            order->remaining -= order->display;
-            level.add_order(order);
-            return true;
+            stats_.riskRejects[i].set(counters.risk_rejects[i]);
         }
-        return false;
     }
 
-    template <typename BookType>
-    void cleanup_empty_level(BookType &book, Price price)
+    void refresh_gauges()
+    {
+        gauges_.poolAllocated.set(order_pool_.allocated_count());
+        gauges_.poolCapacity.set(order_pool_.total_capacity());
+        gauges_.bidLevels.set(bids_.size());
+        gauges_.askLevels.set(asks_.size());
+        gauges_.indexedOrders.set(orders_.size());
+        gauges_.pendingStops.set(stop_manager_.pending_stop_count());
+    }
+
+    // Every message that changes the book ends here; rejects leave it as it was
+    void end_message()
+    {
+        refresh_gauges();
+        publish_l2();
+    }
+
+    void finish_report(ExecutionReport &report, uint64_t trades_before, uint64_t stops_before)
+    {
+        report.trade_count = static_cast<uint32_t>(stats_.totalTrades - trades_before);
+        report.stops_triggered = static_cast<uint32_t>(stats_.totalStopTriggered - stops_before);
+        end_message();
+    }
+
+    ExecutionReport submit_order(OrderId id, Side side, Price price, Quantity qty,
+                                 Quantity disp, Quantity display_size, OrderType type,
+                                 uint32_t ownerID, Price stop_price, uint32_t session_id,
+                                 TradeSink sink, const ScreenedOrder *screened = nullptr);
+
+    // Crosses order against the contra side up to limit_price (ignored for
+    // MARKET); picks the match_kernel for the order's side and type
+    void match_order(Order *order, Price limit_price, TradeSink sink);
+
+    template <Side S, typename Type>
+    void match_kernel(Order *order, Price limit_price, TradeSink &sink);
+
+    // Fills order against one level in chunks, see QueueChunk
+    void sweep_level(Order *order, PriceLevel &level, Price price, TradeSink &sink);
+
+    // Fills order against one level order by order, stepping over its own
+    void sweep_past_own(Order *order, PriceLevel &level, Price price, TradeSink &sink);
+
+    template <Side S>
+    auto &contra_ladder()
+    {
+        if constexpr (S == Side::BUY)
+            return asks_;
+        else
+            return bids_;
+    }
+
+    // Other owners' visible quantity through the limit reaches the order's;
+    // the level-total pre-check is the caller's (match_kernel)
+    bool aon_fillable(const Order *order, Price limit_price);
+
+    // Puts a limit order's unfilled display on its level; indexing is the caller's
+    void rest_order(Order *order, Price price);
+
+    // Takes a live order off its level or the stops and retires it;
+    // message_time_ and the L2 publish are the caller's
+    void cancel_live_order(Order *order);
+
+    template <typename Match>
+    size_t mass_cancel(uint32_t owner, Match &&match);
+
+    ExecutionReport submit_modify(OrderId id, Price new_price, Quantity new_quantity, TradeSink sink);
+
+    BatchReport submit_quotes(uint32_t owner, uint32_t session_id, const QuoteUpdate *quotes,
+                              size_t count, TradeSink sink);
+
+    bool handle_iceberg_refill(Order *order, PriceLevel &level)
     {
-        auto price_it = book.find(price);
-        if (price_it != book.end() && price_it->second.empty())
+        if (order->type == OrderType::ICEBERG && order->remaining > 0)
         {
-            book.erase(price_it);
+            Quantity display_size = order_pool_.cold(order).display_size;
+            order->display = static_cast<int32_t>(min<Quantity>(order->remaining, display_size));
+            level.add_order(order_pool_, order);
+            journal(L3EventType::MODIFY, order, order_pool_.cold(order).price, order->display, order->display);
+            return true;
         }
+        return false;
     }
 
 public:
-    OrderBook() : order_pool_(2000000), trade_pool_(500000), stop_cascade_depth_(0)
+    OrderBook(const OrderBookConfig &config = OrderBookConfig{})
+        : bids_(config.ladder, &tick_table_), asks_(config.ladder, &tick_table_), order_pool_(config.order_pool_size, config.order_pool_limit, config.arena),
+          trade_buffer_(config.trade_buffer_capacity), last_trade_price_(0), clock_(config.clock),
+          message_time_(0), session_reader_(-1), l2_sequence_(0), l3_journal_(nullptr)
     {
-        orders_.reserve(500000);
-        trade_buffer_.reserve(1000);
+        orders_.reserve(config.order_index_reserve);
 
         risk_manager_.set_tick_table(&tick_table_);
+        if (config.validate_sessions)
+        {
+            session_reader_ = session_manager_.register_reader();
+        }
     }
 
     size_t get_order_pool_available() const { return order_pool_.available_count(); }
 
     ~OrderBook()
     {
-        for (auto &[id, order] : orders_)
-        {
-            order_pool_.release(order);
-        }
-
-        for (Trade *trade : trade_buffer_)
-        {
-            trade_pool_.release(trade);
-        }
+        orders_.for_each([this](OrderId, Order *order)
+                         { order_pool_.release(order); });
     }
 
     RiskManager &get_risk_manager() { return risk_manager_; }
     StopOrderManager &get_stop_manager() { return stop_manager_; }
+    EngineClock &clock() { return clock_; }
+    SessionManager &get_session_manager() { return session_manager_; }
+
+    // nullptr unless built with ENGINE_STAGE_TIMERS
+    const StageTimers *stage_timers() const
+    {
+#ifdef ENGINE_STAGE_TIMERS
+        return &stage_timers_;
+#else
+        return nullptr;
+#endif
+    }
 
     vector<Trade> add_order(OrderId id, Side side, Price price, Quantity qty,
                             Quantity disp, Quantity display_size, OrderType type,
                             uint32_t ownerID, Price stop_price = 0, uint32_t session_id = 0);
 
-    void process_triggered_stops(vector<Trade> &trades);
-    void add_market_order(Order *order, vector<Trade> &trades);
-    bool add_FOK_order(Order *order, vector<Trade> &trades);
+    // Streams each trade into sink as it happens, nothing is allocated
+    template <typename Sink>
+    ExecutionReport add_order(OrderId id, Side side, Price price, Quantity qty,
+                              Quantity disp, Quantity display_size, OrderType type,
+                              uint32_t ownerID, Price stop_price, uint32_t session_id, Sink &&sink)
+    {
+        return submit_order(id, side, price, qty, disp, display_size, type, ownerID,
+                            stop_price, session_id, TradeSink(sink));
+    }
+
+    // Stateless first half of add_order: quantity range, static risk limits
+    // and tick rounding. Reads only configuration, so another thread may run
+    // it ahead of the matcher once limits are set.
+    ScreenedOrder screen_order(Price price, Quantity qty, Quantity disp, OrderType type,
+                               uint32_t ownerID, Price stop_price) const;
+
+    // add_order for an order that already went through screen_order
+    template <typename Sink>
+    ExecutionReport add_screened_order(OrderId id, Side side, const ScreenedOrder &screened, Quantity qty,
+                                       Quantity disp, Quantity display_size, OrderType type,
+                                       uint32_t ownerID, uint32_t session_id, Sink &&sink)
+    {
+        return submit_order(id, side, screened.price, qty, disp, display_size, type, ownerID,
+                            screened.stop_price, session_id, TradeSink(sink), &screened);
+    }
+
+    // Same, collecting into the book's reusable buffer, valid until the next call
+    const TradeBuffer &add_order_buffered(OrderId id, Side side, Price price, Quantity qty,
+                                          Quantity disp, Quantity display_size, OrderType type,
+                                          uint32_t ownerID, Price stop_price, uint32_t session_id,
+                                          ExecutionReport *report = nullptr)
+    {
+        trade_buffer_.clear();
+        ExecutionReport result = add_order(id, side, price, qty, disp, display_size, type, ownerID,
+                                           stop_price, session_id, trade_buffer_);
+        if (report)
+        {
+            *report = result;
+        }
+        return trade_buffer_;
+    }
+
+    // Changes a resting limit or iceberg order to new_quantity untraded at
+    // new_price. A size-down at the same price is done in place and keeps
+    // time priority; anything else takes the order off its level, matches
+    // it again at the new price and rests it at the back of the queue,
+    // reusing its slot and index entry. Risk looks only at what grows.
+    template <typename Sink>
+    ExecutionReport modify_order(OrderId id, Price new_price, Quantity new_quantity, Sink &&sink)
+    {
+        return submit_modify(id, new_price, new_quantity, TradeSink(sink));
+    }
+
+    // Cancels and re-enters a market maker's quotes in one step. The batch
+    // is screened as a whole (sizes, price bands, one rate-limit draw for
+    // all new quotes) and rejected without changes if any quote fails.
+    // Otherwise the replaced orders are cancelled first, then each quote
+    // matches and rests in order; stops are checked and L2 published once.
+    template <typename Sink>
+    BatchReport replace_quotes(uint32_t owner, uint32_t session_id, const QuoteUpdate *quotes,
+                               size_t count, Sink &&sink)
+    {
+        return submit_quotes(owner, session_id, quotes, count, TradeSink(sink));
+    }
+
+    // Mass cancels over one owner's live orders, pending stops included;
+    // each returns how many were cancelled
+    size_t cancel_all_orders(uint32_t owner);
+    size_t cancel_session_orders(uint32_t owner, uint32_t session_id);
+    size_t cancel_side_orders(uint32_t owner, Side side);
+
+    void process_triggered_stops(TradeSink sink, Price last_trade_price);
     bool cancel_order(OrderId id);
 
+    // L2 deltas after every message that changes a level; an empty sink detaches
+    void set_l2_sink(L2Sink sink)
+    {
+        l2_sink_ = sink;
+        l2_touched_.clear();
+        if (l2_sink_)
+        {
+            l2_touched_.reserve(256);
+            l2_deltas_.reserve(256);
+        }
+    }
+
+    // Order-by-order events into journal, nullptr stops journaling. The book
+    // only produces; drain the journal on another thread (L3JournalWriter).
+    void set_l3_journal(L3Journal *journal) { l3_journal_ = journal; }
+
+    // Binary snapshot of both sides, pending stops, risk state, book
+    // counters and the session id counter, written to a temp file, synced and
+    // renamed into place. journal_sequence is the last input it includes.
+    bool save_snapshot(const string &filename, uint64_t journal_sequence);
+
+    // Into an empty book with the same configuration; false on a missing,
+    // corrupt or mismatched file or when the order store is too small, and
+    // the book is then only fit to be discarded
+    bool load_snapshot(const string &filename, uint64_t &journal_sequence);
+
+    // Best max_levels levels of one side, best first, from the level totals
+    size_t get_depth(Side side, size_t max_levels, vector<L2Level> &out);
+
     size_t order_count() const { return orders_.size(); }
     size_t bid_levels() const { return bids_.size(); }
     size_t ask_levels() const { return asks_.size(); }
-    Price best_bid() const { return bids_.empty() ? 0 : bids_.begin()->first; }
-    Price best_ask() const { return asks_.empty() ? 0 : asks_.begin()->first; }
+    Price best_bid() const { return bids_.best_price(); }
+    Price best_ask() const { return asks_.best_price(); }
 
-    void print_stats() const {}
+    // Safe from any thread: every field is a relaxed load
+    void sample_telemetry(TelemetryBook &out) const
+    {
+        out.orders = stats_.totalOrders;
+        out.trades = stats_.totalTrades;
+        out.volume = stats_.totalVolumes;
+        out.cancelled = stats_.totalCancelledOrders;
+        out.stops_triggered = stats_.totalStopTriggered;
+        out.risk_rejected = stats_.totalRiskRejected;
+        out.modified = stats_.totalModifiedOrders;
+        for (size_t i = 0; i < RiskManager::RESULT_COUNT; i++)
+        {
+            out.risk_rejects[i] = stats_.riskRejects[i];
+        }
+        out.pool_allocated = gauges_.poolAllocated;
+        out.pool_capacity = gauges_.poolCapacity;
+        out.bid_levels = gauges_.bidLevels;
+        out.ask_levels = gauges_.askLevels;
+        out.indexed_orders = gauges_.indexedOrders;
+        out.pending_stops = gauges_.pendingStops;
+    }
+
+    void print_stats() const
+    {
+        cout << "\n=== BOOK STATISTICS ===" << endl;
+        cout << "Orders: " << stats_.totalOrders << ", Modified: " << stats_.totalModifiedOrders
+             << ", Cancelled: " << stats_.totalCancelledOrders << endl;
+        cout << "Trades: " << stats_.totalTrades << ", Volume: " << stats_.totalVolumes << endl;
+        cout << "Stops Triggered: " << stats_.totalStopTriggered << endl;
+        cout << "Risk Rejected: " << stats_.totalRiskRejected << endl;
+        for (size_t i = 1; i < RiskManager::RESULT_COUNT; i++)
+        {
+            if (stats_.riskRejects[i] > 0)
+            {
+                cout << "  " << RiskManager::result_name(static_cast<RiskManager::RiskResult>(i)) << ": "
+                     << stats_.riskRejects[i] << endl;
+            }
+        }
+    }
 
     void print_pool_stats() const
     {
         cout << "\n=== MEMORY POOL STATISTICS ===" << endl;
         cout << "Order Pool - Available: " << order_pool_.available_count()
              << ", Allocated: " << order_pool_.allocated_count()
-             << ", Capacity: " << order_pool_.total_capacity() << endl;
-        cout << "Trade Pool - Available: " << trade_pool_.available_count()
-             << ", Allocated: " << trade_pool_.allocated_count()
-             << ", Capacity: " << trade_pool_.total_capacity() << endl;
+             << ", Capacity: " << order_pool_.total_capacity() << "/" << order_pool_.max_capacity()
+             << ", Pages: " << page_backing_name(order_pool_.page_backing())
+             << ", NUMA node: " << order_pool_.numa_node() << endl;
+        cout << "Trade Buffer - High Water: " << trade_buffer_.high_water()
+             << ", Capacity: " << trade_buffer_.capacity() << endl;
 
         // Pool efficiency metrics
         double order_utilization = double(order_pool_.allocated_count()) / order_pool_.total_capacity() * 100.0;
-        double trade_utilization = double(trade_pool_.allocated_count()) / trade_pool_.total_capacity() * 100.0;
+        double trade_utilization = double(trade_buffer_.high_water()) / trade_buffer_.capacity() * 100.0;
         cout << "Order Pool Utilization: " << fixed << setprecision(1) << order_utilization << "%" << endl;
-        cout << "Trade Pool Utilization: " << fixed << setprecision(1) << trade_utilization << "%" << endl;
+        cout << "Trade Buffer Utilization: " << fixed << setprecision(1) << trade_utilization << "%" << endl;
 
         if (order_utilization > 80.0)
         {
@@ -207,7 +648,7 @@ public:
         }
         if (trade_utilization > 80.0)
         {
-            cout << "  WARNING: Trade pool utilization >80% - consider expanding" << endl;
+            cout << "  WARNING: Trade buffer utilization >80% - consider expanding" << endl;
         }
     }
 };
\ No newline at end of file
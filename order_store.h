@@ -0,0 +1,137 @@
+#pragma once
+#include "types.h"
+#include "arena.h"
+
+// Order pool split into two parallel arrays indexed by slot: the 32-byte hot
+// records the matcher walks and the cold attributes it rarely needs. Each
+// array sits in its own arena reserved for max_capacity slots up front, so
+// hot expansion commits more of the same range and slots and pointers never
+// move. Only capacity is committed (and pre-faulted) at construction; slots
+// are handed out from a high-water mark before the free list, so nothing is
+// written per slot either. acquire returns nullptr only when the store is at
+// max_capacity or the kernel refuses more memory. The free list is threaded
+// through the hot records' next links.
+class OrderStore
+{
+private:
+    Arena hot_arena_;
+    Arena cold_arena_;
+    Order *hot_;
+    OrderCold *cold_;
+    size_t capacity_;     // committed slots
+    size_t max_capacity_; // reserved slots
+    size_t fresh_;        // slots at and above this were never handed out
+    size_t allocated_count_;
+    uint32_t free_head_;
+
+    static size_t reserve_count(size_t capacity, size_t max_capacity)
+    {
+        if (capacity == 0 || capacity >= NO_ORDER_SLOT || max_capacity >= NO_ORDER_SLOT)
+        {
+            throw invalid_argument("Order store capacity out of range");
+        }
+        return max(capacity, max_capacity);
+    }
+
+    // Commits both arrays through count slots
+    bool commit(size_t count)
+    {
+        if (!hot_arena_.commit(count * sizeof(Order)) || !cold_arena_.commit(count * sizeof(OrderCold)))
+            return false;
+
+        // Whole pages may hold a few more slots than asked for
+        size_t committed = min(hot_arena_.committed() / sizeof(Order), cold_arena_.committed() / sizeof(OrderCold));
+        capacity_ = min(committed, max_capacity_);
+        return true;
+    }
+
+    // Hot expansion: at least doubles what is committed, up to max_capacity
+    bool grow(size_t needed)
+    {
+        if (capacity_ >= max_capacity_)
+            return false;
+        return commit(min(max_capacity_, max(capacity_ + needed, 2 * capacity_)));
+    }
+
+public:
+    // max_capacity 0 keeps the store at capacity
+    explicit OrderStore(size_t capacity, size_t max_capacity = 0, const ArenaConfig &arena = ArenaConfig{})
+        : hot_arena_(reserve_count(capacity, max_capacity) * sizeof(Order), arena),
+          cold_arena_(reserve_count(capacity, max_capacity) * sizeof(OrderCold), arena),
+          hot_(reinterpret_cast<Order *>(hot_arena_.data())), cold_(reinterpret_cast<OrderCold *>(cold_arena_.data())),
+          capacity_(0), max_capacity_(reserve_count(capacity, max_capacity)), fresh_(0), allocated_count_(0),
+          free_head_(NO_ORDER_SLOT)
+    {
+        if (!commit(capacity))
+        {
+            throw bad_alloc();
+        }
+    }
+
+    OrderStore(const OrderStore &) = delete;
+    OrderStore &operator=(const OrderStore &) = delete;
+
+    Order *acquire()
+    {
+        uint32_t slot;
+        if (free_head_ != NO_ORDER_SLOT)
+        {
+            slot = free_head_;
+            free_head_ = hot_[slot].next;
+        }
+        else if (fresh_ < capacity_ || grow(1))
+        {
+            slot = static_cast<uint32_t>(fresh_++);
+        }
+        else
+        {
+            return nullptr;
+        }
+
+        Order *order = new (&hot_[slot]) Order();
+        new (&cold_[slot]) OrderCold();
+        allocated_count_++;
+        return order;
+    }
+
+    void release(Order *order)
+    {
+        if (order == nullptr)
+            return;
+        assert(owns(order) && "order does not belong to this store");
+
+        order->next = free_head_;
+        free_head_ = slot(order);
+        allocated_count_--;
+    }
+
+    // Commits ahead so the next count acquires cannot fail; false when the
+    // store cannot hold that many more
+    bool reserve(size_t count)
+    {
+        size_t committed_free = capacity_ - allocated_count_;
+        if (committed_free >= count)
+            return true;
+        return grow(count - committed_free) && capacity_ - allocated_count_ >= count;
+    }
+
+    uint32_t slot(const Order *order) const { return static_cast<uint32_t>(order - hot_); }
+    Order *at(uint32_t slot) { return &hot_[slot]; }
+    const Order *at(uint32_t slot) const { return &hot_[slot]; }
+
+    OrderCold &cold(const Order *order) { return cold_[slot(order)]; }
+    const OrderCold &cold(const Order *order) const { return cold_[slot(order)]; }
+
+    bool owns(const Order *order) const
+    {
+        return order >= hot_ && order < hot_ + fresh_;
+    }
+
+    // Counts what hot expansion could still add
+    size_t available_count() const { return max_capacity_ - allocated_count_; }
+    size_t allocated_count() const { return allocated_count_; }
+    size_t total_capacity() const { return capacity_; }
+    size_t max_capacity() const { return max_capacity_; }
+    PageBacking page_backing() const { return hot_arena_.backing(); }
+    int numa_node() const { return hot_arena_.numa_node(); }
+};
@@ -0,0 +1,254 @@
+#include "persistence.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr const char *JOURNAL_NAME = "journal.wal";
+    constexpr const char *SNAPSHOT_PREFIX = "snapshot-";
+    constexpr const char *SNAPSHOT_SUFFIX = ".bin";
+    constexpr size_t SNAPSHOTS_KEPT = 2;
+
+    string journal_path(const string &directory)
+    {
+        return (filesystem::path(directory) / JOURNAL_NAME).string();
+    }
+
+    // Creates the directory if needed; an unusable one shows up as a journal that failed to open
+    string prepare_directory(const string &directory)
+    {
+        error_code error;
+        filesystem::create_directories(directory, error);
+        return journal_path(directory);
+    }
+
+    // Zero-padded so name order is sequence order
+    string snapshot_path(const string &directory, uint64_t sequence)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "%s%020llu%s", SNAPSHOT_PREFIX, static_cast<unsigned long long>(sequence),
+                 SNAPSHOT_SUFFIX);
+        return (filesystem::path(directory) / name).string();
+    }
+
+    // Newest first
+    vector<string> list_snapshots(const string &directory)
+    {
+        vector<string> snapshots;
+        error_code error;
+        for (const auto &entry : filesystem::directory_iterator(directory, error))
+        {
+            string name = entry.path().filename().string();
+            if (name.rfind(SNAPSHOT_PREFIX, 0) == 0 && name.size() > strlen(SNAPSHOT_SUFFIX) &&
+                name.compare(name.size() - strlen(SNAPSHOT_SUFFIX), string::npos, SNAPSHOT_SUFFIX) == 0)
+            {
+                snapshots.push_back(entry.path().string());
+            }
+        }
+        sort(snapshots.rbegin(), snapshots.rend());
+        return snapshots;
+    }
+
+    // A snapshot ends with a copy of its header, so a cut-short file is
+    // rejected before anything is loaded into the book
+    bool snapshot_complete(const string &filename)
+    {
+        FILE *file = fopen(filename.c_str(), "rb");
+        if (file == nullptr)
+            return false;
+        char head[24], tail[24];
+        bool complete = fread(head, sizeof(head), 1, file) == 1 && fseeko(file, -static_cast<off_t>(sizeof(tail)), SEEK_END) == 0 &&
+                        fread(tail, sizeof(tail), 1, file) == 1 && memcmp(head, tail, sizeof(head)) == 0;
+        fclose(file);
+        return complete;
+    }
+}
+
+uint32_t InputJournal::checksum(const JournalRecord &record)
+{
+    JournalRecord copy = record;
+    copy.checksum = 0;
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&copy);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(copy); i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+InputJournal::InputJournal(const string &filename, size_t batch_size)
+    : fd_(::open(filename.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644)), batch_size_(max<size_t>(batch_size, 1)),
+      next_sequence_(1), synced_sequence_(0)
+{
+    batch_.reserve(batch_size_);
+    if (fd_ < 0)
+        return;
+
+    // Keep the longest intact prefix; only the last records are read
+    struct stat info;
+    uint64_t count = fstat(fd_, &info) == 0 ? static_cast<uint64_t>(info.st_size) / sizeof(JournalRecord) : 0;
+    while (count > 0)
+    {
+        JournalRecord record;
+        off_t offset = static_cast<off_t>((count - 1) * sizeof(JournalRecord));
+        if (pread(fd_, &record, sizeof(record), offset) == static_cast<ssize_t>(sizeof(record)) &&
+            record.sequence == count && record.checksum == checksum(record))
+            break;
+        count--;
+    }
+    if (ftruncate(fd_, static_cast<off_t>(count * sizeof(JournalRecord))) != 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+        return;
+    }
+    next_sequence_ = count + 1;
+    synced_sequence_ = count;
+}
+
+InputJournal::~InputJournal()
+{
+    if (fd_ >= 0)
+    {
+        sync();
+        ::close(fd_);
+    }
+}
+
+uint64_t InputJournal::append(JournalRecordType type, int64_t timestamp, const ReplayOrder &order)
+{
+    JournalRecord record{next_sequence_++, timestamp, type, 0, order};
+    record.checksum = checksum(record);
+    batch_.push_back(record);
+    if (batch_.size() >= batch_size_)
+    {
+        sync();
+    }
+    return record.sequence;
+}
+
+bool InputJournal::sync()
+{
+    if (fd_ < 0)
+        return false;
+    if (batch_.empty())
+        return true;
+
+    const char *data = reinterpret_cast<const char *>(batch_.data());
+    size_t size = batch_.size() * sizeof(JournalRecord);
+    while (size > 0)
+    {
+        ssize_t written = ::write(fd_, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    if (fdatasync(fd_) != 0)
+        return false;
+
+    synced_sequence_ = batch_.back().sequence;
+    batch_.clear();
+    return true;
+}
+
+JournaledBook::JournaledBook(OrderBook &book, const PersistenceConfig &config)
+    : book_(book), config_(config),
+      journal_(prepare_directory(config.directory), config.sync_batch),
+      since_snapshot_(0)
+{
+}
+
+void JournaledBook::after_input()
+{
+    if (config_.snapshot_every > 0 && ++since_snapshot_ >= config_.snapshot_every)
+    {
+        snapshot();
+    }
+}
+
+bool JournaledBook::cancel_order(OrderId id)
+{
+    ReplayOrder order{};
+    order.id = id;
+    int64_t timestamp = book_.clock().message_time();
+    book_.clock().pin_next(timestamp);
+    journal_.append(JournalRecordType::CANCEL_ORDER, timestamp, order);
+    bool cancelled = book_.cancel_order(id);
+    after_input();
+    return cancelled;
+}
+
+void JournaledBook::mark_to_market(Price price)
+{
+    ReplayOrder order{};
+    order.price = price;
+    journal_.append(JournalRecordType::MARK_TO_MARKET, 0, order);
+    book_.get_risk_manager().mark_to_market(price);
+    after_input();
+}
+
+bool JournaledBook::snapshot()
+{
+    since_snapshot_ = 0;
+    uint64_t sequence = journal_.last_sequence();
+    if (!journal_.sync() || !book_.save_snapshot(snapshot_path(config_.directory, sequence), sequence))
+        return false;
+
+    vector<string> snapshots = list_snapshots(config_.directory);
+    for (size_t i = SNAPSHOTS_KEPT; i < snapshots.size(); i++)
+    {
+        remove(snapshots[i].c_str());
+    }
+    return true;
+}
+
+RecoveryStats JournaledBook::recover(OrderBook &book, const string &directory)
+{
+    auto start_time = steady_clock::now();
+    RecoveryStats stats;
+
+    for (const string &snapshot : list_snapshots(directory))
+    {
+        if (snapshot_complete(snapshot))
+        {
+            stats.snapshot_loaded = book.load_snapshot(snapshot, stats.snapshot_sequence);
+            stats.ok = stats.snapshot_loaded;
+            break;
+        }
+    }
+    if (!stats.ok)
+        return stats;
+
+    stats.replayed = InputJournal::read_after(journal_path(directory), stats.snapshot_sequence,
+                                              [&book](const JournalRecord &record)
+                                              {
+                                                  switch (record.type)
+                                                  {
+                                                  case JournalRecordType::NEW_ORDER:
+                                                      book.clock().pin_next(record.timestamp);
+                                                      replay_order(book, record.order, [](const Trade &) {});
+                                                      break;
+                                                  case JournalRecordType::CANCEL_ORDER:
+                                                      book.clock().pin_next(record.timestamp);
+                                                      book.cancel_order(record.order.id);
+                                                      break;
+                                                  case JournalRecordType::MARK_TO_MARKET:
+                                                      book.get_risk_manager().mark_to_market(record.order.price);
+                                                      break;
+                                                  }
+                                              });
+    stats.last_sequence = stats.snapshot_sequence + stats.replayed;
+    stats.elapsed_us = duration_cast<microseconds>(steady_clock::now() - start_time).count();
+    return stats;
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include "order_book.h"
+#include "replay_format.h"
+
+enum class JournalRecordType : uint32_t
+{
+    NEW_ORDER,
+    CANCEL_ORDER,  // order.id
+    MARK_TO_MARKET // order.price
+};
+
+// Fixed-size input record. Sequences start at 1 and are dense, so record n
+// sits at offset (n - 1) * sizeof(JournalRecord) and the tail after a
+// snapshot is found without scanning.
+struct JournalRecord
+{
+    uint64_t sequence;
+    int64_t timestamp; // book time the message was processed at
+    JournalRecordType type;
+    uint32_t checksum; // FNV-1a of the other fields, catches a torn last write
+    ReplayOrder order;
+};
+
+static_assert(sizeof(JournalRecord) == 72, "journal record layout is part of the file format");
+
+// Append-only write-ahead log of every input that changes a book. Records
+// are buffered and written plus fdatasync'd once per batch (group commit),
+// so a crash loses at most the batch not yet synced. Opening an existing
+// journal checks only its last records and cuts off a torn tail.
+class InputJournal
+{
+private:
+    int fd_;
+    vector<JournalRecord> batch_;
+    size_t batch_size_;
+    uint64_t next_sequence_;
+    uint64_t synced_sequence_;
+
+public:
+    InputJournal(const string &filename, size_t batch_size = 256);
+    ~InputJournal();
+
+    InputJournal(const InputJournal &) = delete;
+    InputJournal &operator=(const InputJournal &) = delete;
+
+    bool is_open() const { return fd_ >= 0; }
+
+    // Returns the record's sequence
+    uint64_t append(JournalRecordType type, int64_t timestamp, const ReplayOrder &order);
+
+    // Writes and syncs the pending batch; false on an I/O error
+    bool sync();
+
+    uint64_t last_sequence() const { return next_sequence_ - 1; }
+    uint64_t synced_sequence() const { return synced_sequence_; }
+
+    static uint32_t checksum(const JournalRecord &record);
+
+    // Reads records after from_sequence in order, stopping at the first
+    // missing or damaged one; returns how many fn was called for
+    template <typename Fn>
+    static uint64_t read_after(const string &filename, uint64_t from_sequence, Fn &&fn);
+};
+
+struct PersistenceConfig
+{
+    string directory;                 // journal.wal and snapshot-<sequence>.bin
+    size_t sync_batch = 256;          // records per fdatasync
+    uint64_t snapshot_every = 100000; // inputs between snapshots, 0 = only on request
+};
+
+struct RecoveryStats
+{
+    bool ok = true;               // false if the newest snapshot failed to load, the book is then unusable
+    bool snapshot_loaded = false;
+    uint64_t snapshot_sequence = 0; // last input covered by the snapshot
+    uint64_t replayed = 0;          // journal tail applied on top
+    uint64_t last_sequence = 0;
+    int64_t elapsed_us = 0;
+};
+
+// A book whose every input is journaled before it is applied, with
+// periodic snapshots. Journaled messages keep the book time they were
+// processed at, so replaying the tail reproduces the book exactly.
+class JournaledBook
+{
+private:
+    OrderBook &book_;
+    PersistenceConfig config_;
+    InputJournal journal_;
+    uint64_t since_snapshot_;
+
+    void after_input();
+
+public:
+    JournaledBook(OrderBook &book, const PersistenceConfig &config);
+
+    bool is_open() const { return journal_.is_open(); }
+
+    template <typename Sink>
+    ExecutionReport add_order(const ReplayOrder &order, Sink &&sink)
+    {
+        int64_t timestamp = book_.clock().message_time();
+        book_.clock().pin_next(timestamp);
+        journal_.append(JournalRecordType::NEW_ORDER, timestamp, order);
+        ExecutionReport report = replay_order(book_, order, sink);
+        after_input();
+        return report;
+    }
+
+    bool cancel_order(OrderId id);
+    void mark_to_market(Price price);
+
+    // Syncs the journal, then snapshots the book under the current sequence
+    bool snapshot();
+    bool sync() { return journal_.sync(); }
+
+    uint64_t last_sequence() const { return journal_.last_sequence(); }
+    OrderBook &book() { return book_; }
+
+    // Loads the newest readable snapshot in directory into an empty book,
+    // then replays the journal records after it. Without a snapshot the
+    // whole journal is replayed onto the book as configured by the caller.
+    static RecoveryStats recover(OrderBook &book, const string &directory);
+};
+
+template <typename Fn>
+uint64_t InputJournal::read_after(const string &filename, uint64_t from_sequence, Fn &&fn)
+{
+    FILE *file = fopen(filename.c_str(), "rb");
+    if (file == nullptr)
+        return 0;
+
+    uint64_t applied = 0;
+    if (fseeko(file, static_cast<off_t>(from_sequence * sizeof(JournalRecord)), SEEK_SET) == 0)
+    {
+        JournalRecord record;
+        uint64_t expected = from_sequence + 1;
+        while (fread(&record, sizeof(record), 1, file) == 1 && record.sequence == expected &&
+               record.checksum == checksum(record))
+        {
+            fn(record);
+            applied++;
+            expected++;
+        }
+    }
+    fclose(file);
+    return applied;
+}
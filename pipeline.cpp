@@ -0,0 +1,193 @@
+#include "pipeline.h"
+
+namespace
+{
+    template <typename T>
+    void push_blocking(SpscQueue<T> &ring, const T &item)
+    {
+        unsigned spins = 0;
+        while (!ring.try_push(item))
+        {
+            idle_backoff(spins);
+        }
+    }
+
+    // False once upstream is done and the ring is drained
+    template <typename T>
+    bool pop_blocking(SpscQueue<T> &ring, const atomic<bool> &upstream_done, T &item)
+    {
+        unsigned spins = 0;
+        while (!ring.try_pop(item))
+        {
+            // Everything pushed before done was set is visible now
+            if (upstream_done.load(memory_order_acquire))
+                return ring.try_pop(item);
+            idle_backoff(spins);
+        }
+        return true;
+    }
+}
+
+ReplayPipeline::ReplayPipeline(OrderBook &book, const PipelineConfig &config)
+    : book_(book), config_(config), decoded_(config.ring_capacity), screened_(config.ring_capacity),
+      events_(config.ring_capacity), decode_done_(false), risk_done_(false), match_done_(false)
+{
+}
+
+int ReplayPipeline::stage_core(size_t stage) const
+{
+    if (stage < config_.cores.size())
+        return config_.cores[stage];
+    return static_cast<int>(stage % max(1u, thread::hardware_concurrency()));
+}
+
+bool ReplayPipeline::run(const string &filename, Result &result)
+{
+    unique_ptr<ReplayFile> replay;
+    ifstream csv;
+    if (ReplayFile::is_replay_file(filename))
+    {
+        replay = make_unique<ReplayFile>(filename);
+        if (!replay->is_open())
+            return false;
+    }
+    else
+    {
+        csv.open(filename);
+        if (!csv.is_open())
+            return false;
+    }
+
+    result = Result{};
+    result.by_type.assign(TYPE_COUNT, LatencyHistogram());
+    decode_done_.store(false, memory_order_relaxed);
+    risk_done_.store(false, memory_order_relaxed);
+    match_done_.store(false, memory_order_relaxed);
+
+    auto start_time = high_resolution_clock::now();
+    thread stages[] = {
+        thread([&]
+               { decode_stage(replay.get(), replay ? nullptr : &csv, result); }),
+        thread([&]
+               { risk_stage(); }),
+        thread([&]
+               { match_stage(); }),
+        thread([&]
+               { publish_stage(result); }),
+    };
+    for (thread &stage : stages)
+    {
+        stage.join();
+    }
+    result.elapsed_ms = duration_cast<milliseconds>(high_resolution_clock::now() - start_time).count();
+    return true;
+}
+
+void ReplayPipeline::decode_stage(const ReplayFile *replay, istream *csv, Result &result)
+{
+    pin_thread_to_core(stage_core(0));
+
+    StagedOrder staged{};
+    if (replay)
+    {
+        for (const ReplayOrder &order : *replay)
+        {
+            staged.order = order;
+            staged.decode_ticks = TscClock::ticks();
+            push_blocking(decoded_, staged);
+        }
+    }
+    else
+    {
+        string line;
+        getline(*csv, line);
+        while (getline(*csv, line))
+        {
+            if (!parse_csv_order(line, staged.order))
+            {
+                result.decode_errors++;
+                continue;
+            }
+            staged.decode_ticks = TscClock::ticks();
+            push_blocking(decoded_, staged);
+        }
+    }
+    decode_done_.store(true, memory_order_release);
+}
+
+void ReplayPipeline::risk_stage()
+{
+    pin_thread_to_core(stage_core(1));
+
+    StagedOrder staged;
+    while (pop_blocking(decoded_, decode_done_, staged))
+    {
+        const ReplayOrder &order = staged.order;
+        staged.screened = book_.screen_order(order.price, order.quantity, order.disp,
+                                             static_cast<OrderType>(order.type), order.owner, order.stop_price);
+        push_blocking(screened_, staged);
+    }
+    risk_done_.store(true, memory_order_release);
+}
+
+void ReplayPipeline::match_stage()
+{
+    pin_thread_to_core(stage_core(2));
+
+    StagedOrder staged;
+    PublishedEvent event{};
+    uint64_t order_count = 0;
+    auto publish_trade = [&](const Trade &trade)
+    {
+        event.is_trade = true;
+        event.trade = trade;
+        push_blocking(events_, event);
+    };
+
+    while (pop_blocking(screened_, risk_done_, staged))
+    {
+        const ReplayOrder &order = staged.order;
+        event.order_type = order.type;
+        event.decode_ticks = staged.decode_ticks;
+        event.report = book_.add_screened_order(order.id, static_cast<Side>(order.side), staged.screened,
+                                                order.quantity, order.disp, order.display_size,
+                                                static_cast<OrderType>(order.type), order.owner,
+                                                order.session_id, publish_trade);
+        event.is_trade = false;
+        push_blocking(events_, event);
+
+        // Same cadence as the serial run, so risk state evolves identically
+        if (++order_count % config_.mark_interval == 0)
+        {
+            Price current_price = book_.best_bid() > 0 ? (book_.best_bid() + book_.best_ask()) / 2 : 100000;
+            book_.get_risk_manager().mark_to_market(current_price);
+        }
+    }
+    match_done_.store(true, memory_order_release);
+}
+
+void ReplayPipeline::publish_stage(Result &result)
+{
+    pin_thread_to_core(stage_core(3));
+
+    TradeChecksum checksum;
+    PublishedEvent event;
+    while (pop_blocking(events_, match_done_, event))
+    {
+        if (event.is_trade)
+        {
+            checksum(event.trade);
+            continue;
+        }
+
+        result.orders++;
+        result.trades += event.report.trade_count;
+        if (event.report.status == ExecStatus::REJECTED_RISK || event.report.status == ExecStatus::REJECTED_NO_MEMORY)
+        {
+            result.rejected++;
+        }
+        size_t type = min<size_t>(event.order_type, TYPE_COUNT - 1);
+        result.by_type[type].record(TscClock::ticks_to_ns(TscClock::ticks() - event.decode_ticks));
+    }
+    result.trade_checksum = checksum.value();
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "order_book.h"
+#include "spsc_queue.h"
+#include "replay_format.h"
+
+struct PipelineConfig
+{
+    size_t ring_capacity = 16384;
+    vector<int> cores;           // decode, risk, match, publish; empty = stage i on core i % hardware threads
+    size_t mark_interval = 1000; // orders between mark_to_market calls, as in the serial run
+};
+
+// Replays one file into one book through four stages, each on its own
+// pinned thread and joined by bounded SPSC rings:
+//   decode (CSV or mmap'd binary) -> static risk (OrderBook::screen_order)
+//   -> matcher -> publisher (trades and per-order reports)
+// Only the matcher touches book state and it sees orders in file order, so
+// the book and its trades are identical to a serial replay with the same
+// clock; the other stages just move work off the matcher's core.
+class ReplayPipeline
+{
+public:
+    static constexpr size_t TYPE_COUNT = static_cast<size_t>(OrderType::AON_IOC) + 1;
+
+    struct Result
+    {
+        uint64_t orders = 0;
+        uint64_t trades = 0;
+        uint64_t rejected = 0;
+        uint64_t decode_errors = 0;
+        uint64_t trade_checksum = 0;
+        int64_t elapsed_ms = 0;
+        vector<LatencyHistogram> by_type; // decode to published, per order type
+    };
+
+private:
+    struct StagedOrder
+    {
+        ReplayOrder order;
+        ScreenedOrder screened; // filled in by the risk stage
+        uint64_t decode_ticks;  // TscClock ticks when decoded
+    };
+
+    struct PublishedEvent
+    {
+        bool is_trade;
+        uint8_t order_type;
+        uint64_t decode_ticks;
+        Trade trade;
+        ExecutionReport report;
+    };
+
+    OrderBook &book_;
+    PipelineConfig config_;
+    SpscQueue<StagedOrder> decoded_;
+    SpscQueue<StagedOrder> screened_;
+    SpscQueue<PublishedEvent> events_;
+    atomic<bool> decode_done_;
+    atomic<bool> risk_done_;
+    atomic<bool> match_done_;
+
+    int stage_core(size_t stage) const;
+
+    void decode_stage(const ReplayFile *replay, istream *csv, Result &result);
+    void risk_stage();
+    void match_stage();
+    void publish_stage(Result &result);
+
+public:
+    ReplayPipeline(OrderBook &book, const PipelineConfig &config = PipelineConfig{});
+
+    ReplayPipeline(const ReplayPipeline &) = delete;
+    ReplayPipeline &operator=(const ReplayPipeline &) = delete;
+
+    // Runs the file through every stage and returns once all are drained;
+    // false if the file cannot be opened
+    bool run(const string &filename, Result &result);
+};
@@ -0,0 +1,442 @@
+#pragma once
+#include "types.h"
+#include "price_level.h"
+#include "tick_table.h"
+
+enum class LadderMode
+{
+    ARRAY, // contiguous window of levels indexed by tick offset from a movable base
+    MAP    // red-black tree, for instruments with very wide price ranges
+};
+
+struct LadderConfig
+{
+    LadderMode mode = LadderMode::ARRAY;
+    Price base_price = 0;   // lowest price in the window, 0 = anchor on first insert
+    size_t capacity = 8192; // slots in the window
+    bool tick_indexed = true; // one slot per valid tick when the ladder has a tick table, else per price unit
+};
+
+// One side of the book. In ARRAY mode levels live in a fixed window with a
+// two-level bitmap of non-empty slots and a cursor on the best one, so best
+// price, insert and level removal never allocate. A price outside the window
+// re-centres it; if the live range no longer fits, the ladder falls back to MAP.
+// Slots are keyed by the tick table's dense tick index when one is given, so
+// coarse bands cost no empty slots; a price off the tick grid forces MAP.
+template <Side S>
+class PriceLadder
+{
+private:
+    static constexpr bool IS_BID = (S == Side::BUY);
+    static constexpr size_t NPOS = static_cast<size_t>(-1);
+    using Compare = conditional_t<IS_BID, greater<Price>, less<Price>>;
+
+    LadderMode mode_;
+    const TickSizeTable *ticks_;
+    int64_t base_key_;
+    size_t capacity_;
+    size_t best_idx_;
+    size_t level_count_;
+    vector<PriceLevel> levels_;
+    vector<uint64_t> bitmap_;
+    vector<uint64_t> summary_;
+
+    map<Price, PriceLevel, Compare> map_;
+
+    bool test_bit(size_t idx) const { return (bitmap_[idx >> 6] >> (idx & 63)) & 1; }
+
+    void set_bit(size_t idx)
+    {
+        bitmap_[idx >> 6] |= 1ULL << (idx & 63);
+        summary_[idx >> 12] |= 1ULL << ((idx >> 6) & 63);
+    }
+
+    void clear_bit(size_t idx)
+    {
+        size_t word = idx >> 6;
+        bitmap_[word] &= ~(1ULL << (idx & 63));
+        if (bitmap_[word] == 0)
+        {
+            summary_[word >> 6] &= ~(1ULL << (word & 63));
+        }
+    }
+
+    // First set slot >= from, or NPOS
+    size_t find_next_set(size_t from) const
+    {
+        if (from >= capacity_)
+            return NPOS;
+
+        size_t word = from >> 6;
+        uint64_t bits = bitmap_[word] & (~0ULL << (from & 63));
+        if (bits)
+            return (word << 6) + __builtin_ctzll(bits);
+
+        size_t next_word = word + 1;
+        size_t sword = next_word >> 6;
+        if (sword >= summary_.size())
+            return NPOS;
+
+        uint64_t sbits = summary_[sword] & ((next_word & 63) ? (~0ULL << (next_word & 63)) : ~0ULL);
+        while (true)
+        {
+            if (sbits)
+            {
+                size_t w = (sword << 6) + __builtin_ctzll(sbits);
+                return (w << 6) + __builtin_ctzll(bitmap_[w]);
+            }
+            if (++sword >= summary_.size())
+                return NPOS;
+            sbits = summary_[sword];
+        }
+    }
+
+    // Last set slot <= from, or NPOS
+    size_t find_prev_set(size_t from) const
+    {
+        if (from == NPOS)
+            return NPOS;
+
+        size_t word = from >> 6;
+        uint64_t mask = ((from & 63) == 63) ? ~0ULL : ((1ULL << ((from & 63) + 1)) - 1);
+        uint64_t bits = bitmap_[word] & mask;
+        if (bits)
+            return (word << 6) + 63 - __builtin_clzll(bits);
+        if (word == 0)
+            return NPOS;
+
+        size_t prev_word = word - 1;
+        size_t sword = prev_word >> 6;
+        uint64_t smask = ((prev_word & 63) == 63) ? ~0ULL : ((1ULL << ((prev_word & 63) + 1)) - 1);
+        uint64_t sbits = summary_[sword] & smask;
+        while (true)
+        {
+            if (sbits)
+            {
+                size_t w = (sword << 6) + 63 - __builtin_clzll(sbits);
+                return (w << 6) + 63 - __builtin_clzll(bitmap_[w]);
+            }
+            if (sword == 0)
+                return NPOS;
+            sbits = summary_[--sword];
+        }
+    }
+
+    // Slot after idx in priority order (towards worse prices)
+    size_t next_worse(size_t idx) const
+    {
+        return IS_BID ? (idx == 0 ? NPOS : find_prev_set(idx - 1)) : find_next_set(idx + 1);
+    }
+
+    size_t first_best() const
+    {
+        return IS_BID ? find_prev_set(capacity_ - 1) : find_next_set(0);
+    }
+
+    // Window key of a price: its tick index, or the price itself without a table
+    int64_t key_of(Price price) const
+    {
+        return ticks_ ? ticks_->tick_index(price) : price;
+    }
+
+    Price price_of(size_t idx) const
+    {
+        int64_t key = base_key_ + static_cast<int64_t>(idx);
+        return ticks_ ? ticks_->price_at(key) : key;
+    }
+
+    bool in_window(int64_t key) const
+    {
+        return key >= base_key_ && key < base_key_ + static_cast<int64_t>(capacity_);
+    }
+
+    // Make room for key, either by moving the window or by falling back to MAP
+    void ensure_window(int64_t key)
+    {
+        if (key < 0)
+        {
+            migrate_to_map();
+            return;
+        }
+        if (in_window(key))
+            return;
+
+        if (level_count_ == 0)
+        {
+            base_key_ = max<int64_t>(0, key - static_cast<int64_t>(capacity_ / 2));
+            return;
+        }
+
+        int64_t lo = min(key, base_key_ + static_cast<int64_t>(find_next_set(0)));
+        int64_t hi = max(key, base_key_ + static_cast<int64_t>(find_prev_set(capacity_ - 1)));
+        int64_t span = hi - lo + 1;
+        if (span > static_cast<int64_t>(capacity_))
+        {
+            migrate_to_map();
+            return;
+        }
+        rebase(max<int64_t>(0, lo - (static_cast<int64_t>(capacity_) - span) / 2));
+    }
+
+    void rebase(int64_t new_base)
+    {
+        int64_t delta = new_base - base_key_;
+
+        // Move live levels in place, in an order that never lands on an
+        // unmoved live level: a level clears its old bit as it leaves
+        auto move_level = [&](size_t idx)
+        {
+            size_t target = static_cast<size_t>(static_cast<int64_t>(idx) - delta);
+            swap(levels_[target], levels_[idx]);
+            clear_bit(idx);
+            set_bit(target);
+        };
+        if (delta > 0)
+        {
+            for (size_t idx = find_next_set(0); idx != NPOS; idx = find_next_set(idx + 1))
+            {
+                move_level(idx);
+            }
+        }
+        else if (delta < 0)
+        {
+            for (size_t idx = find_prev_set(capacity_ - 1); idx != NPOS; idx = idx == 0 ? NPOS : find_prev_set(idx - 1))
+            {
+                move_level(idx);
+            }
+        }
+
+        base_key_ = new_base;
+        best_idx_ = first_best();
+    }
+
+    void migrate_to_map()
+    {
+        for (size_t idx = find_next_set(0); idx != NPOS; idx = find_next_set(idx + 1))
+        {
+            map_.emplace(price_of(idx), std::move(levels_[idx]));
+        }
+        mode_ = LadderMode::MAP;
+        best_idx_ = NPOS;
+        vector<PriceLevel>().swap(levels_);
+        vector<uint64_t>().swap(bitmap_);
+        vector<uint64_t>().swap(summary_);
+    }
+
+public:
+    PriceLadder(const LadderConfig &config = LadderConfig{}, const TickSizeTable *ticks = nullptr)
+        : mode_(config.mode), ticks_(config.tick_indexed ? ticks : nullptr), base_key_(0), capacity_(0),
+          best_idx_(NPOS), level_count_(0)
+    {
+        if (config.base_price > 0)
+        {
+            base_key_ = max<int64_t>(0, key_of(config.base_price));
+        }
+        if (mode_ == LadderMode::ARRAY)
+        {
+            if (config.capacity == 0)
+            {
+                throw invalid_argument("Price ladder capacity must be positive");
+            }
+            capacity_ = (config.capacity + 63) & ~size_t(63);
+            levels_.resize(capacity_);
+            bitmap_.assign(capacity_ >> 6, 0);
+            summary_.assign(((capacity_ >> 6) + 63) >> 6, 0);
+        }
+    }
+
+    LadderMode mode() const { return mode_; }
+
+    bool empty() const { return size() == 0; }
+
+    size_t size() const { return mode_ == LadderMode::ARRAY ? level_count_ : map_.size(); }
+
+    Price best_price() const
+    {
+        if (mode_ == LadderMode::ARRAY)
+        {
+            return best_idx_ == NPOS ? 0 : price_of(best_idx_);
+        }
+        return map_.empty() ? 0 : map_.begin()->first;
+    }
+
+    PriceLevel *best_level()
+    {
+        if (mode_ == LadderMode::ARRAY)
+        {
+            return best_idx_ == NPOS ? nullptr : &levels_[best_idx_];
+        }
+        return map_.empty() ? nullptr : &map_.begin()->second;
+    }
+
+    // Price of the next non-empty level worse than price, or 0
+    Price next_price(Price price) const
+    {
+        if (mode_ == LadderMode::MAP)
+        {
+            auto it = map_.upper_bound(price);
+            return it == map_.end() ? 0 : it->first;
+        }
+        int64_t key = key_of(price);
+        if (!in_window(key))
+            return 0;
+        size_t idx = next_worse(static_cast<size_t>(key - base_key_));
+        return idx == NPOS ? 0 : price_of(idx);
+    }
+
+    PriceLevel *find(Price price)
+    {
+        if (mode_ == LadderMode::ARRAY)
+        {
+            int64_t key = key_of(price);
+            if (!in_window(key))
+                return nullptr;
+            size_t idx = static_cast<size_t>(key - base_key_);
+            return test_bit(idx) ? &levels_[idx] : nullptr;
+        }
+        auto it = map_.find(price);
+        return it == map_.end() ? nullptr : &it->second;
+    }
+
+    PriceLevel &get_or_create(Price price)
+    {
+        int64_t key = 0;
+        if (mode_ == LadderMode::ARRAY)
+        {
+            key = key_of(price);
+            ensure_window(key);
+        }
+        if (mode_ == LadderMode::MAP)
+        {
+            return map_[price];
+        }
+
+        size_t idx = static_cast<size_t>(key - base_key_);
+        if (!test_bit(idx))
+        {
+            set_bit(idx);
+            level_count_++;
+            if (best_idx_ == NPOS || (IS_BID ? idx > best_idx_ : idx < best_idx_))
+            {
+                best_idx_ = idx;
+            }
+        }
+        return levels_[idx];
+    }
+
+    // Drop the level at price from the ladder once its last order is gone
+    void remove_if_empty(Price price)
+    {
+        if (mode_ == LadderMode::MAP)
+        {
+            auto it = map_.find(price);
+            if (it != map_.end() && it->second.empty())
+            {
+                map_.erase(it);
+            }
+            return;
+        }
+
+        int64_t key = key_of(price);
+        if (!in_window(key))
+            return;
+        size_t idx = static_cast<size_t>(key - base_key_);
+        if (!test_bit(idx) || !levels_[idx].empty())
+            return;
+
+        clear_bit(idx);
+        level_count_--;
+        if (idx == best_idx_)
+        {
+            best_idx_ = next_worse(idx);
+        }
+    }
+
+    // True if the levels from best through limit_price show at least
+    // quantity between them. Reads level totals only, never an order. In
+    // ARRAY mode empty slots hold zero totals, so the window is summed one
+    // bitmap word (64 slots) at a time as a branch-free reduction over the
+    // contiguous level array, skipping words with no live level.
+    bool covers(Price limit_price, int64_t quantity) const
+    {
+        if (quantity <= 0)
+            return true;
+
+        int64_t key = key_of(limit_price);
+        if (mode_ == LadderMode::MAP || limit_price <= 0 || key < 0)
+        {
+            // Off the tick grid: walk live levels, still totals only
+            int64_t total = 0;
+            auto within = [limit_price](Price price)
+            { return IS_BID ? price >= limit_price : price <= limit_price; };
+            if (mode_ == LadderMode::MAP)
+            {
+                for (const auto &[price, level] : map_)
+                {
+                    if (!within(price))
+                        return false;
+                    if ((total += level.visible_quantity) >= quantity)
+                        return true;
+                }
+                return false;
+            }
+            for (size_t idx = best_idx_; idx != NPOS && within(price_of(idx)); idx = next_worse(idx))
+            {
+                if ((total += levels_[idx].visible_quantity) >= quantity)
+                    return true;
+            }
+            return false;
+        }
+
+        if (best_idx_ == NPOS)
+            return false;
+        int64_t offset = key - base_key_;
+        int64_t best = static_cast<int64_t>(best_idx_);
+        if (IS_BID ? offset > best : offset < best)
+            return false;
+
+        // Slots [lo, hi] are inside the limit
+        size_t lo = IS_BID ? static_cast<size_t>(max<int64_t>(offset, 0)) : best_idx_;
+        size_t hi = IS_BID ? best_idx_ : static_cast<size_t>(min<int64_t>(offset, capacity_ - 1));
+        size_t first_word = IS_BID ? hi >> 6 : lo >> 6;
+        size_t last_word = IS_BID ? lo >> 6 : hi >> 6;
+        int64_t total = 0;
+        for (size_t word = first_word;; word = IS_BID ? word - 1 : word + 1)
+        {
+            if (bitmap_[word] != 0)
+            {
+                size_t begin = max(word << 6, lo);
+                size_t end = min((word << 6) + 63, hi);
+                for (size_t idx = begin; idx <= end; idx++)
+                {
+                    total += levels_[idx].visible_quantity;
+                }
+                if (total >= quantity)
+                    return true;
+            }
+            if (word == last_word)
+                return false;
+        }
+    }
+
+    // Visit non-empty levels from best to worst until fn returns false
+    template <typename Fn>
+    void for_each_level(Fn &&fn)
+    {
+        if (mode_ == LadderMode::MAP)
+        {
+            for (auto &[price, level] : map_)
+            {
+                if (!fn(price, level))
+                    return;
+            }
+            return;
+        }
+
+        for (size_t idx = best_idx_; idx != NPOS; idx = next_worse(idx))
+        {
+            if (!fn(price_of(idx), levels_[idx]))
+                return;
+        }
+    }
+};
@@ -0,0 +1,201 @@
+#pragma once
+#include "types.h"
+#include "order_store.h"
+
+// Intrusive FIFO of resting orders, linked through the hot records' prev/next slots
+struct OrderQueue
+{
+    uint32_t head = NO_ORDER_SLOT;
+    uint32_t tail = NO_ORDER_SLOT;
+
+    bool empty() const { return head == NO_ORDER_SLOT; }
+
+    void push_back(OrderStore &store, Order *order)
+    {
+        uint32_t slot = store.slot(order);
+        order->prev = tail;
+        order->next = NO_ORDER_SLOT;
+        if (tail != NO_ORDER_SLOT)
+        {
+            store.at(tail)->next = slot;
+        }
+        else
+        {
+            head = slot;
+        }
+        tail = slot;
+    }
+
+    void unlink(OrderStore &store, Order *order)
+    {
+        if (order->prev != NO_ORDER_SLOT)
+        {
+            store.at(order->prev)->next = order->next;
+        }
+        else
+        {
+            head = order->next;
+        }
+        if (order->next != NO_ORDER_SLOT)
+        {
+            store.at(order->next)->prev = order->prev;
+        }
+        else
+        {
+            tail = order->prev;
+        }
+        order->prev = NO_ORDER_SLOT;
+        order->next = NO_ORDER_SLOT;
+    }
+};
+
+// The head of one queue copied out as structure-of-arrays for a sweep.
+// One pass gathers slot, displayed quantity and owner along with a running
+// total in which the aggressor's own orders count zero (masked, not
+// branched on); it stops early once the total covers what the aggressor
+// wants, so a small order reads no more than it fills. The cut point is
+// then a fixed-width compare over the totals that the compiler vectorizes.
+// The queue stays the source of truth and a chunk is stale once the queue
+// changes.
+struct QueueChunk
+{
+    static constexpr size_t CAPACITY = 16;
+
+    uint32_t slot[CAPACITY];
+    int32_t quantity[CAPACITY]; // displayed
+    uint32_t owner[CAPACITY];
+    int64_t total[CAPACITY]; // inclusive running total of other owners' quantity; flat past count
+    size_t count = 0;
+
+    void gather(OrderStore &store, const OrderQueue &queue, uint32_t aggressor, int64_t wanted)
+    {
+        count = 0;
+        int64_t running = 0;
+        for (uint32_t next = queue.head; next != NO_ORDER_SLOT && count < CAPACITY && running < wanted; count++)
+        {
+            const Order *order = store.at(next);
+            slot[count] = next;
+            quantity[count] = order->display;
+            owner[count] = order->ownerID;
+            running += order->ownerID != aggressor ? order->display : 0;
+            total[count] = running;
+            next = order->next;
+        }
+        for (size_t i = count; i < CAPACITY; i++)
+        {
+            total[i] = running;
+        }
+    }
+
+    // How many leading orders an aggressor with wanted left gets through:
+    // every one, or up to and including the one that completes it. Its own
+    // orders on the way are cancelled, not filled.
+    size_t reach(int64_t wanted) const
+    {
+        size_t short_of = 0;
+        for (size_t i = 0; i < CAPACITY; i++)
+        {
+            short_of += total[i] < wanted;
+        }
+        return short_of < count ? short_of + 1 : count;
+    }
+};
+
+// Queues hold slots, not pointers, so levels move freely (ladder rebase or
+// map fallback). Callers pass the store the slots belong to. The level keeps
+// running totals of displayed quantity and resting orders, so depth reads
+// never walk the queues; fills on a resting order go through reduce().
+struct PriceLevel
+{
+    OrderQueue mm_orders;
+    OrderQueue regular_orders;
+    int64_t visible_quantity = 0;
+    uint32_t order_count = 0;
+
+    Order *front(OrderStore &store)
+    {
+        if (!mm_orders.empty())
+        {
+            return store.at(mm_orders.head);
+        }
+        else if (!regular_orders.empty())
+        {
+            return store.at(regular_orders.head);
+        }
+        return nullptr;
+    }
+
+    void pop_front(OrderStore &store)
+    {
+        erase(store, front(store));
+    }
+
+    void add_order(OrderStore &store, Order *order)
+    {
+        visible_quantity += order->display;
+        order_count++;
+        if (order->is_market_maker)
+        {
+            mm_orders.push_back(store, order);
+        }
+        else
+        {
+            regular_orders.push_back(store, order);
+        }
+    }
+
+    bool empty() const
+    {
+        return mm_orders.empty() && regular_orders.empty();
+    }
+
+    // A fill of qty against a resting order; it stays queued until popped
+    void reduce(Order *order, Quantity qty)
+    {
+        order->display -= static_cast<int32_t>(qty);
+        order->remaining -= static_cast<int32_t>(qty);
+        visible_quantity -= qty;
+    }
+
+    // Unlinks the first n orders of queue, as gathered in chunk, in one
+    // step; their displayed quantity leaves the level with them
+    void detach_front(OrderStore &store, OrderQueue &queue, const QueueChunk &chunk, size_t n)
+    {
+        uint32_t rest = store.at(chunk.slot[n - 1])->next;
+        queue.head = rest;
+        if (rest != NO_ORDER_SLOT)
+        {
+            store.at(rest)->prev = NO_ORDER_SLOT;
+        }
+        else
+        {
+            queue.tail = NO_ORDER_SLOT;
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            Order *order = store.at(chunk.slot[i]);
+            order->prev = NO_ORDER_SLOT;
+            order->next = NO_ORDER_SLOT;
+            visible_quantity -= chunk.quantity[i];
+        }
+        order_count -= static_cast<uint32_t>(n);
+    }
+
+    // order must be resting on this level
+    void erase(OrderStore &store, Order *order)
+    {
+        if (order == nullptr)
+            return;
+
+        visible_quantity -= order->display;
+        order_count--;
+        if (order->is_market_maker)
+        {
+            mm_orders.unlink(store, order);
+        }
+        else
+        {
+            regular_orders.unlink(store, order);
+        }
+    }
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <algorithm>
+
+// Fixed-size token bucket, refilled continuously at rate tokens/sec up to
+// burst tokens. Clocked by the caller's nanosecond timestamp, so a check is
+// a few integer ops with no clock read and no allocation. Tokens are kept
+// in units of 1e-9 so refill stays exact in integer math.
+class TokenBucket
+{
+private:
+    static constexpr int64_t SCALE = 1000000000LL;
+
+    int64_t rate_;
+    int64_t capacity_;
+    int64_t tokens_;
+    int64_t last_ns_;
+
+    void refill(int64_t now_ns)
+    {
+        int64_t elapsed = now_ns - last_ns_;
+        if (elapsed <= 0)
+            return;
+
+        last_ns_ = now_ns;
+        // Long idle gaps just top the bucket up; also keeps elapsed * rate in range
+        if (rate_ == 0 || elapsed >= (capacity_ - tokens_) / rate_ + 1)
+        {
+            tokens_ = capacity_;
+        }
+        else
+        {
+            tokens_ += elapsed * rate_;
+        }
+    }
+
+public:
+    TokenBucket() : rate_(0), capacity_(0), tokens_(0), last_ns_(0) {}
+
+    TokenBucket(int64_t rate_per_sec, int64_t burst) { configure(rate_per_sec, burst); }
+
+    void configure(int64_t rate_per_sec, int64_t burst)
+    {
+        rate_ = std::max<int64_t>(rate_per_sec, 0);
+        capacity_ = std::max<int64_t>(burst, 0) * SCALE;
+        tokens_ = capacity_;
+        last_ns_ = 0;
+    }
+
+    int64_t rate() const { return rate_; }
+
+    // Full bucket state, for snapshots
+    struct State
+    {
+        int64_t rate;
+        int64_t capacity;
+        int64_t tokens;
+        int64_t last_ns;
+    };
+
+    State state() const { return State{rate_, capacity_, tokens_, last_ns_}; }
+
+    void restore(const State &state)
+    {
+        rate_ = state.rate;
+        capacity_ = state.capacity;
+        tokens_ = state.tokens;
+        last_ns_ = state.last_ns;
+    }
+
+    // Takes count tokens if all are available; false means rate limited
+    bool try_acquire(int64_t now_ns, int64_t count = 1)
+    {
+        refill(now_ns);
+        if (tokens_ / SCALE < count)
+            return false;
+        tokens_ -= count * SCALE;
+        return true;
+    }
+
+    void reset()
+    {
+        tokens_ = capacity_;
+        last_ns_ = 0;
+    }
+};
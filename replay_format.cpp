@@ -0,0 +1,211 @@
+#include "replay_format.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    // Parses an integer field ending at ',' or end of line, advancing pos
+    template <typename Int>
+    bool parse_field(const char *&pos, const char *end, Int &out)
+    {
+        bool negative = false;
+        if (pos < end && *pos == '-')
+        {
+            negative = true;
+            pos++;
+        }
+        if (pos >= end || *pos < '0' || *pos > '9')
+            return false;
+
+        int64_t value = 0;
+        while (pos < end && *pos >= '0' && *pos <= '9')
+        {
+            value = value * 10 + (*pos - '0');
+            pos++;
+        }
+        if (pos < end)
+        {
+            if (*pos != ',')
+                return false;
+            pos++;
+        }
+        out = static_cast<Int>(negative ? -value : value);
+        return true;
+    }
+
+    bool parse_word(const char *&pos, const char *end, const char *&word, size_t &length)
+    {
+        word = pos;
+        while (pos < end && *pos != ',')
+        {
+            pos++;
+        }
+        length = pos - word;
+        if (pos < end)
+        {
+            pos++;
+        }
+        return length > 0;
+    }
+
+    bool word_is(const char *word, size_t length, const char *name)
+    {
+        return length == strlen(name) && memcmp(word, name, length) == 0;
+    }
+}
+
+bool parse_csv_order(const string &line, ReplayOrder &out)
+{
+    const char *pos = line.data();
+    const char *end = pos + line.size();
+    const char *word;
+    size_t length;
+
+    out = ReplayOrder{};
+    if (!parse_field(pos, end, out.id) || !parse_word(pos, end, word, length))
+        return false;
+    out.side = static_cast<uint8_t>(word_is(word, length, "BUY") ? Side::BUY : Side::SELL);
+
+    if (!parse_field(pos, end, out.price) || !parse_field(pos, end, out.quantity) ||
+        !parse_word(pos, end, word, length))
+        return false;
+
+    OrderType type = OrderType::GTC;
+    for (OrderType candidate : {OrderType::GTC, OrderType::IOC, OrderType::FOK, OrderType::MARKET,
+                                OrderType::STOP_LOSS, OrderType::ICEBERG, OrderType::AON_IOC})
+    {
+        if (word_is(word, length, order_type_name(candidate)))
+        {
+            type = candidate;
+            break;
+        }
+    }
+    out.type = static_cast<uint8_t>(type);
+
+    return parse_field(pos, end, out.disp) && parse_field(pos, end, out.display_size) &&
+           parse_field(pos, end, out.owner) && parse_field(pos, end, out.stop_price) &&
+           parse_field(pos, end, out.session_id) && parse_word(pos, end, word, length);
+}
+
+ReplayWriter::ReplayWriter(const string &filename, size_t buffer_records)
+    : file_(fopen(filename.c_str(), "wb")), count_(0), failed_(false)
+{
+    buffer_.reserve(max<size_t>(buffer_records, 1));
+    if (file_)
+    {
+        ReplayHeader header{};
+        memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+        header.version = REPLAY_VERSION;
+        header.record_size = sizeof(ReplayOrder);
+        failed_ = fwrite(&header, sizeof(header), 1, file_) != 1;
+    }
+}
+
+ReplayWriter::~ReplayWriter()
+{
+    close();
+}
+
+void ReplayWriter::flush()
+{
+    if (file_ && !buffer_.empty())
+    {
+        size_t written = fwrite(buffer_.data(), sizeof(ReplayOrder), buffer_.size(), file_);
+        failed_ = failed_ || written != buffer_.size();
+        count_ += written;
+    }
+    buffer_.clear();
+}
+
+bool ReplayWriter::close()
+{
+    if (!file_)
+        return !failed_;
+
+    flush();
+    failed_ = failed_ || fseek(file_, offsetof(ReplayHeader, count), SEEK_SET) != 0 ||
+              fwrite(&count_, sizeof(count_), 1, file_) != 1;
+    failed_ = fclose(file_) != 0 || failed_;
+    file_ = nullptr;
+    return !failed_;
+}
+
+ReplayFile::ReplayFile(const string &filename)
+    : mapping_(nullptr), mapped_size_(0), records_(nullptr), count_(0)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ReplayHeader))
+    {
+        ::close(fd);
+        return;
+    }
+
+    mapped_size_ = st.st_size;
+    void *mapping = mmap(nullptr, mapped_size_, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return;
+    mapping_ = mapping;
+    madvise(mapping_, mapped_size_, MADV_SEQUENTIAL);
+
+    const auto *header = static_cast<const ReplayHeader *>(mapping_);
+    size_t available = (mapped_size_ - sizeof(ReplayHeader)) / sizeof(ReplayOrder);
+    if (memcmp(header->magic, REPLAY_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != REPLAY_VERSION || header->record_size != sizeof(ReplayOrder) ||
+        header->count > available)
+    {
+        return;
+    }
+
+    records_ = reinterpret_cast<const ReplayOrder *>(static_cast<const char *>(mapping_) + sizeof(ReplayHeader));
+    count_ = header->count;
+}
+
+ReplayFile::~ReplayFile()
+{
+    if (mapping_)
+    {
+        munmap(mapping_, mapped_size_);
+    }
+}
+
+bool ReplayFile::is_replay_file(const string &filename)
+{
+    ifstream file(filename, ios::binary);
+    char magic[sizeof(REPLAY_MAGIC)] = {};
+    file.read(magic, sizeof(magic));
+    return file.gcount() == sizeof(magic) && memcmp(magic, REPLAY_MAGIC, sizeof(magic)) == 0;
+}
+
+int64_t convert_csv_to_replay(const string &csv_filename, const string &replay_filename)
+{
+    ifstream csv(csv_filename);
+    if (!csv.is_open())
+        return -1;
+
+    ReplayWriter writer(replay_filename);
+    if (!writer.is_open())
+        return -1;
+
+    string line;
+    getline(csv, line);
+
+    ReplayOrder order;
+    while (getline(csv, line))
+    {
+        if (parse_csv_order(line, order))
+        {
+            writer.write(order);
+        }
+    }
+    if (!writer.close() || csv.bad())
+        return -1;
+    return static_cast<int64_t>(writer.count());
+}
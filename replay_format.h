@@ -0,0 +1,132 @@
+#pragma once
+#include "types.h"
+
+// Fixed-width binary order file: a 32-byte header followed by count
+// 48-byte records, so a mapped file can be walked as a plain array
+struct ReplayHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t count;
+    uint64_t reserved;
+};
+
+struct ReplayOrder
+{
+    OrderId id;
+    Price price;
+    Price stop_price;
+    int32_t quantity;
+    int32_t disp;
+    int32_t display_size;
+    uint32_t owner;
+    uint32_t session_id;
+    uint8_t side; // Side
+    uint8_t type; // OrderType
+    uint16_t reserved;
+};
+
+static_assert(sizeof(ReplayHeader) == 32, "replay header must stay 32 bytes");
+static_assert(sizeof(ReplayOrder) == 48, "replay record must stay 48 bytes");
+static_assert(is_trivially_copyable_v<ReplayOrder>, "replay record is read straight from the mapping");
+
+inline constexpr char REPLAY_MAGIC[8] = {'T', 'E', 'O', 'R', 'D', 'E', 'R', 'S'};
+inline constexpr uint32_t REPLAY_VERSION = 1;
+
+inline const char *order_type_name(OrderType type)
+{
+    switch (type)
+    {
+    case OrderType::GTC:
+        return "GTC";
+    case OrderType::IOC:
+        return "IOC";
+    case OrderType::FOK:
+        return "FOK";
+    case OrderType::MARKET:
+        return "MARKET";
+    case OrderType::STOP_LOSS:
+        return "STOP_LOSS";
+    case OrderType::ICEBERG:
+        return "ICEBERG";
+    case OrderType::AON_IOC:
+        return "AON_IOC";
+    }
+    return "GTC";
+}
+
+// Feed one record to anything with the OrderBook add_order(..., sink) signature
+template <typename Book, typename Sink>
+decltype(auto) replay_order(Book &book, const ReplayOrder &rec, Sink &&sink)
+{
+    return book.add_order(rec.id, static_cast<Side>(rec.side), rec.price, rec.quantity,
+                          rec.disp, rec.display_size, static_cast<OrderType>(rec.type),
+                          rec.owner, rec.stop_price, rec.session_id, sink);
+}
+
+// Parse one CSV data row (order_id,side,price,quantity,type,disp,display_size,
+// owner,stop_price,session_id,ip_address) without allocating
+bool parse_csv_order(const string &line, ReplayOrder &out);
+
+// Buffered writer, fills in the header count when closed
+class ReplayWriter
+{
+private:
+    FILE *file_;
+    vector<ReplayOrder> buffer_;
+    uint64_t count_;
+    bool failed_; // a short write, seek or close; sticky
+
+    void flush();
+
+public:
+    explicit ReplayWriter(const string &filename, size_t buffer_records = 4096);
+    ~ReplayWriter();
+
+    ReplayWriter(const ReplayWriter &) = delete;
+    ReplayWriter &operator=(const ReplayWriter &) = delete;
+
+    bool is_open() const { return file_ != nullptr; }
+    uint64_t count() const { return count_; }
+
+    void write(const ReplayOrder &order)
+    {
+        buffer_.push_back(order);
+        if (buffer_.size() == buffer_.capacity())
+        {
+            flush();
+        }
+    }
+
+    // Writes the header count and closes; false if any write failed
+    bool close();
+};
+
+// Read-only mmap of a replay file; records are used in place
+class ReplayFile
+{
+private:
+    void *mapping_;
+    size_t mapped_size_;
+    const ReplayOrder *records_;
+    size_t count_;
+
+public:
+    explicit ReplayFile(const string &filename);
+    ~ReplayFile();
+
+    ReplayFile(const ReplayFile &) = delete;
+    ReplayFile &operator=(const ReplayFile &) = delete;
+
+    static bool is_replay_file(const string &filename);
+
+    bool is_open() const { return records_ != nullptr; }
+    size_t size() const { return count_; }
+    const ReplayOrder *begin() const { return records_; }
+    const ReplayOrder *end() const { return records_ + count_; }
+    const ReplayOrder &operator[](size_t i) const { return records_[i]; }
+};
+
+// Returns the number of orders converted, or -1 on I/O error
+int64_t convert_csv_to_replay(const string &csv_filename, const string &replay_filename);
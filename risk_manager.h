@@ -1,6 +1,9 @@
 #pragma once
 #include "types.h"
 #include "tick_table.h"
+#include "rate_limiter.h"
+#include "snapshot_io.h"
+#include "flat_index.h"
 
 class CircuitBreaker
 {
@@ -36,23 +39,143 @@ public:
 
     bool is_trading_halted() const { return is_triggered_; }
 
+    struct State
+    {
+        Price upper_limit;
+        Price lower_limit;
+        bool is_triggered;
+        int64_t trigger_time;
+    };
+
+    State state() const { return State{upper_limit_, lower_limit_, is_triggered_, static_cast<int64_t>(trigger_time_)}; }
+
+    void restore(const State &state)
+    {
+        upper_limit_ = state.upper_limit;
+        lower_limit_ = state.lower_limit;
+        is_triggered_ = state.is_triggered;
+        trigger_time_ = static_cast<time_t>(state.trigger_time);
+    }
+
     void resume_trading() { is_triggered_ = false; }
 };
 
-class RiskManager
+struct RiskLimits
+{
+    int64_t max_position;
+    int64_t max_order_value;
+    int64_t max_order_qty;
+    int64_t daily_loss_limit;
+    double max_price_deviation;
+    int32_t max_orders_per_sec;
+    int64_t max_daily_volume;
+};
+
+// Cross-book risk state shared by every matcher thread. One cache-line
+// record per trader in a dense array indexed by ownerID; matchers add
+// their deltas with relaxed atomics and check_order only does loads.
+// Limits are immutable snapshots swapped in on the slow path.
+class SharedRiskService
 {
 public:
-    struct RiskLimits
+    struct TraderTotals
     {
-        int64_t max_position;
-        int64_t max_order_value;
-        int64_t max_order_qty;
-        int64_t daily_loss_limit;
-        double max_price_deviation;
-        int32_t max_orders_per_sec;
-        int64_t max_daily_volume;
+        int64_t gross_position; // sum over symbols of |net position|
+        int64_t realized_pnl;
+        int64_t unrealized_pnl;
+        int64_t daily_volume;
+    };
+
+private:
+    struct alignas(64) TraderRecord
+    {
+        atomic<const RiskLimits *> limits{nullptr};
+        atomic<int64_t> gross_position{0};
+        atomic<int64_t> realized_pnl{0};
+        atomic<int64_t> unrealized_pnl{0};
+        atomic<int64_t> daily_volume{0};
     };
 
+    unique_ptr<TraderRecord[]> records_;
+    size_t max_traders_;
+
+    // Every limits snapshot ever published stays alive, so readers never
+    // see a freed one. Changes are rare, so this never grows much.
+    vector<unique_ptr<RiskLimits>> limit_store_;
+    mutex limits_mutex_;
+
+public:
+    explicit SharedRiskService(size_t max_traders = 65536)
+        : records_(make_unique<TraderRecord[]>(max_traders)), max_traders_(max_traders) {}
+
+    size_t max_traders() const { return max_traders_; }
+    bool has_trader(uint32_t trader_id) const { return trader_id < max_traders_; }
+
+    void set_trader_limits(uint32_t trader_id, const RiskLimits &limits)
+    {
+        if (!has_trader(trader_id))
+        {
+            throw out_of_range("Trader id exceeds shared risk capacity");
+        }
+
+        lock_guard<mutex> lock(limits_mutex_);
+        limit_store_.push_back(make_unique<RiskLimits>(limits));
+        records_[trader_id].limits.store(limit_store_.back().get(), memory_order_release);
+    }
+
+    const RiskLimits *limits(uint32_t trader_id) const
+    {
+        return has_trader(trader_id) ? records_[trader_id].limits.load(memory_order_acquire) : nullptr;
+    }
+
+    void add_fill(uint32_t trader_id, int64_t gross_delta, int64_t realized_delta, int64_t volume)
+    {
+        if (!has_trader(trader_id))
+            return;
+        auto &record = records_[trader_id];
+        record.gross_position.fetch_add(gross_delta, memory_order_relaxed);
+        record.realized_pnl.fetch_add(realized_delta, memory_order_relaxed);
+        record.daily_volume.fetch_add(volume, memory_order_relaxed);
+    }
+
+    void add_unrealized(uint32_t trader_id, int64_t delta)
+    {
+        if (has_trader(trader_id) && delta != 0)
+        {
+            records_[trader_id].unrealized_pnl.fetch_add(delta, memory_order_relaxed);
+        }
+    }
+
+    TraderTotals totals(uint32_t trader_id) const
+    {
+        if (!has_trader(trader_id))
+        {
+            return TraderTotals{0, 0, 0, 0};
+        }
+        const auto &record = records_[trader_id];
+        return TraderTotals{record.gross_position.load(memory_order_relaxed),
+                            record.realized_pnl.load(memory_order_relaxed),
+                            record.unrealized_pnl.load(memory_order_relaxed),
+                            record.daily_volume.load(memory_order_relaxed)};
+    }
+
+    // Start of day, with matchers stopped
+    void reset_daily_stats()
+    {
+        for (size_t i = 0; i < max_traders_; i++)
+        {
+            records_[i].realized_pnl.store(0, memory_order_relaxed);
+            records_[i].unrealized_pnl.store(0, memory_order_relaxed);
+            records_[i].daily_volume.store(0, memory_order_relaxed);
+        }
+    }
+};
+
+class RiskManager
+{
+public:
+    using RiskLimits = ::RiskLimits;
+
     struct Position
     {
         int64_t quantity;
@@ -74,72 +197,132 @@ public:
         REJECTED_VOLUME_LIMIT,
         REJECTED_INVALID_TICK_SIZE
     };
+    static constexpr size_t RESULT_COUNT = static_cast<size_t>(RiskResult::REJECTED_INVALID_TICK_SIZE) + 1;
 
-private:
-    struct RateLimit
+    static const char *result_name(RiskResult result)
     {
-        deque<int64_t> timestamps;
-        int32_t count_this_second;
-    };
+        switch (result)
+        {
+        case RiskResult::APPROVED:
+            return "APPROVED";
+        case RiskResult::REJECTED_POSITION_LIMIT:
+            return "POSITION_LIMIT";
+        case RiskResult::REJECTED_ORDER_SIZE:
+            return "ORDER_SIZE";
+        case RiskResult::REJECTED_FAT_FINGER:
+            return "FAT_FINGER";
+        case RiskResult::REJECTED_LOSS_LIMIT:
+            return "LOSS_LIMIT";
+        case RiskResult::REJECTED_RATE_LIMIT:
+            return "RATE_LIMIT";
+        case RiskResult::REJECTED_CIRCUIT_BREAKER:
+            return "CIRCUIT_BREAKER";
+        case RiskResult::REJECTED_VOLUME_LIMIT:
+            return "VOLUME_LIMIT";
+        case RiskResult::REJECTED_INVALID_TICK_SIZE:
+            return "INVALID_TICK_SIZE";
+        }
+        return "?";
+    }
 
-    unordered_map<uint32_t, Position> positions_;
-    unordered_map<uint32_t, RiskLimits> trader_limits_;
-    unordered_map<uint32_t, RateLimit> rate_limits_;
+private:
+    FlatIndex<uint32_t, Position> positions_;
+    FlatIndex<uint32_t, RiskLimits> trader_limits_;
+    FlatIndex<uint32_t, TokenBucket> rate_limits_;
     Price last_trade_price_;
     CircuitBreaker circuit_breaker_;
     const TickSizeTable *tick_table_;
+    SharedRiskService *shared_;
+
+    const RiskLimits *find_limits(uint32_t trader_id) const
+    {
+        if (shared_)
+        {
+            return shared_->limits(trader_id);
+        }
+        return trader_limits_.find(trader_id);
+    }
 
 public:
-    RiskManager() : last_trade_price_(0), tick_table_(nullptr) {}
+    RiskManager() : last_trade_price_(0), tick_table_(nullptr), shared_(nullptr) {}
 
-    RiskResult check_order(const Order &order)
+    // Checks that depend only on the order and the configured limits. Const
+    // and free of book state, so a pipeline stage can run it on another
+    // thread ahead of the matcher; check_order assumes it has passed.
+    RiskResult check_static(uint32_t owner, OrderType type, Price price, Quantity quantity) const
     {
-        if (order.type == OrderType::STOP_LOSS)
+        if (type == OrderType::STOP_LOSS)
         {
             return RiskResult::APPROVED;
         }
 
-        auto &pos = positions_[order.ownerID];
-        auto limit_it = trader_limits_.find(order.ownerID);
-        if (limit_it == trader_limits_.end())
+        const RiskLimits *limit = find_limits(owner);
+        if (limit == nullptr)
         {
             return RiskResult::REJECTED_POSITION_LIMIT;
         }
-        auto &limit = limit_it->second;
+        if (quantity > limit->max_order_qty || price * quantity > limit->max_order_value)
+        {
+            return RiskResult::REJECTED_ORDER_SIZE;
+        }
+        return RiskResult::APPROVED;
+    }
 
-        int64_t newpos = (order.side == Side::BUY) ? (pos.quantity + order.quantity) : (pos.quantity - order.quantity);
-        if (abs(newpos) > limit.max_position)
+    // Checks against positions, prices and rates seen so far
+    RiskResult check_order(const Order &order, const OrderCold &cold)
+    {
+        if (order.type == OrderType::STOP_LOSS)
         {
-            return RiskResult::REJECTED_POSITION_LIMIT;
+            return RiskResult::APPROVED;
         }
 
-        if (order.quantity > limit.max_order_qty)
+        auto &pos = positions_[order.ownerID];
+        const RiskLimits *limit_ptr = find_limits(order.ownerID);
+        if (limit_ptr == nullptr)
         {
-            return RiskResult::REJECTED_ORDER_SIZE;
+            return RiskResult::REJECTED_POSITION_LIMIT;
         }
+        auto &limit = *limit_ptr;
 
-        if (order.price * order.quantity > limit.max_order_value)
+        int64_t newpos = (order.side == Side::BUY) ? (pos.quantity + cold.quantity) : (pos.quantity - cold.quantity);
+        if (abs(newpos) > limit.max_position)
         {
-            return RiskResult::REJECTED_ORDER_SIZE;
+            return RiskResult::REJECTED_POSITION_LIMIT;
         }
 
-        if (last_trade_price_ > 0 && order.price > 0 &&
-            (abs(order.price - last_trade_price_) / double(last_trade_price_)) > limit.max_price_deviation)
+        if (last_trade_price_ > 0 && cold.price > 0 &&
+            (abs(cold.price - last_trade_price_) / double(last_trade_price_)) > limit.max_price_deviation)
         {
             return RiskResult::REJECTED_FAT_FINGER;
         }
 
-        if (pos.realized_pnl + pos.unrealized_pnl < -limit.daily_loss_limit)
+        int64_t unrealized = unrealized_pnl(pos);
+        if (shared_)
+        {
+            // Loss and volume limits apply across every book the trader is in;
+            // swap this book's last published unrealized for the live figure
+            auto totals = shared_->totals(order.ownerID);
+            int64_t total_pnl = totals.realized_pnl + totals.unrealized_pnl - pos.unrealized_pnl + unrealized;
+            if (total_pnl < -limit.daily_loss_limit)
+            {
+                return RiskResult::REJECTED_LOSS_LIMIT;
+            }
+            if (totals.daily_volume + cold.quantity > limit.max_daily_volume)
+            {
+                return RiskResult::REJECTED_VOLUME_LIMIT;
+            }
+        }
+        else if (pos.realized_pnl + unrealized < -limit.daily_loss_limit)
         {
             return RiskResult::REJECTED_LOSS_LIMIT;
         }
 
-        if (is_rate_limited(order.ownerID))
+        if (is_rate_limited(order.ownerID, cold.timestamp))
         {
             return RiskResult::REJECTED_RATE_LIMIT;
         }
 
-        if (circuit_breaker_.should_halt_trading(order.price))
+        if (circuit_breaker_.should_halt_trading(cold.price))
         {
             return RiskResult::REJECTED_CIRCUIT_BREAKER;
         }
@@ -150,6 +333,8 @@ public:
     void update_position(uint32_t trader_id, const Trade &trade, Side trader_side)
     {
         auto &pos = positions_[trader_id];
+        int64_t old_quantity = pos.quantity;
+        int64_t old_realized = pos.realized_pnl;
 
         if (trader_side == Side::BUY)
         {
@@ -196,6 +381,16 @@ public:
 
         pos.daily_volume += trade.quantity;
         last_trade_price_ = trade.price;
+
+        if (shared_)
+        {
+            // Publish the position marked at this fill so other books see it
+            int64_t old_unrealized = pos.unrealized_pnl;
+            pos.unrealized_pnl = unrealized_pnl(pos);
+            shared_->add_fill(trader_id, abs(pos.quantity) - abs(old_quantity),
+                              pos.realized_pnl - old_realized, trade.quantity);
+            shared_->add_unrealized(trader_id, pos.unrealized_pnl - old_unrealized);
+        }
     }
 
     void set_trader_limits(uint32_t trader_id, const RiskLimits &limits)
@@ -208,58 +403,175 @@ public:
         }
 
         trader_limits_[trader_id] = limits;
+        if (shared_)
+        {
+            shared_->set_trader_limits(trader_id, limits);
+        }
 
-        if (positions_.find(trader_id) == positions_.end())
+        if (!positions_.contains(trader_id))
         {
             positions_[trader_id] = Position{0, 0, 0, 0, 0};
         }
 
-        if (rate_limits_.find(trader_id) == rate_limits_.end())
+        rate_limits_[trader_id].configure(limits.max_orders_per_sec, limits.max_orders_per_sec);
+    }
+
+    // check_order for a resting order being modified, on what the change
+    // adds: position and volume only when the size grows, price band and
+    // breaker only when the price moves. Counts against the rate limit.
+    RiskResult check_modify(const Order &order, Price old_price, Quantity old_quantity,
+                            Price new_price, Quantity new_quantity, int64_t now_ns)
+    {
+        const RiskLimits *limit_ptr = find_limits(order.ownerID);
+        if (limit_ptr == nullptr)
+        {
+            return RiskResult::REJECTED_POSITION_LIMIT;
+        }
+        auto &limit = *limit_ptr;
+
+        if (new_quantity > limit.max_order_qty || new_price * new_quantity > limit.max_order_value)
+        {
+            return RiskResult::REJECTED_ORDER_SIZE;
+        }
+
+        Quantity added = new_quantity - old_quantity;
+        if (added > 0)
+        {
+            auto &pos = positions_[order.ownerID];
+            int64_t newpos = order.side == Side::BUY ? pos.quantity + new_quantity : pos.quantity - new_quantity;
+            if (abs(newpos) > limit.max_position)
+            {
+                return RiskResult::REJECTED_POSITION_LIMIT;
+            }
+            if (shared_ && shared_->totals(order.ownerID).daily_volume + added > limit.max_daily_volume)
+            {
+                return RiskResult::REJECTED_VOLUME_LIMIT;
+            }
+        }
+
+        if (new_price != old_price && last_trade_price_ > 0 &&
+            (abs(new_price - last_trade_price_) / double(last_trade_price_)) > limit.max_price_deviation)
+        {
+            return RiskResult::REJECTED_FAT_FINGER;
+        }
+
+        if (is_rate_limited(order.ownerID, now_ns))
+        {
+            return RiskResult::REJECTED_RATE_LIMIT;
+        }
+
+        if (new_price != old_price && circuit_breaker_.should_halt_trading(new_price))
         {
-            rate_limits_[trader_id] = RateLimit{};
+            return RiskResult::REJECTED_CIRCUIT_BREAKER;
         }
+        return RiskResult::APPROVED;
     }
 
-    bool is_rate_limited(uint32_t trader_id)
+    // check_static and check_order for a batch of one owner's limit orders
+    // with prices already on the tick grid: one limits and position lookup
+    // and one rate-limit draw for the whole batch. Every quote is checked
+    // against the position before the batch, the way a resting quote set
+    // is judged on entry.
+    RiskResult check_quotes(uint32_t owner, int64_t now_ns, const QuoteUpdate *quotes, size_t count)
     {
-        auto it = trader_limits_.find(trader_id);
-        if (it == trader_limits_.end())
+        const RiskLimits *limit_ptr = find_limits(owner);
+        if (limit_ptr == nullptr)
         {
-            return true;
+            return RiskResult::REJECTED_POSITION_LIMIT;
         }
+        auto &limit = *limit_ptr;
+        auto &pos = positions_[owner];
 
-        auto &limit = it->second;
-        auto &rate_limit = rate_limits_[trader_id];
-        auto now = duration_cast<nanoseconds>(high_resolution_clock::now().time_since_epoch()).count();
+        int64_t orders = 0;
+        int64_t volume = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            const QuoteUpdate &quote = quotes[i];
+            if (quote.id == 0)
+                continue;
+            if (quote.quantity > limit.max_order_qty || quote.price * quote.quantity > limit.max_order_value)
+            {
+                return RiskResult::REJECTED_ORDER_SIZE;
+            }
+            int64_t newpos = quote.side == Side::BUY ? pos.quantity + quote.quantity : pos.quantity - quote.quantity;
+            if (abs(newpos) > limit.max_position)
+            {
+                return RiskResult::REJECTED_POSITION_LIMIT;
+            }
+            if (last_trade_price_ > 0 && quote.price > 0 &&
+                (abs(quote.price - last_trade_price_) / double(last_trade_price_)) > limit.max_price_deviation)
+            {
+                return RiskResult::REJECTED_FAT_FINGER;
+            }
+            orders++;
+            volume += quote.quantity;
+        }
+        if (orders == 0)
+        {
+            return RiskResult::APPROVED;
+        }
 
-        while (!rate_limit.timestamps.empty() && (now - rate_limit.timestamps.front()) > 1000000000LL)
+        int64_t unrealized = unrealized_pnl(pos);
+        if (shared_)
+        {
+            auto totals = shared_->totals(owner);
+            int64_t total_pnl = totals.realized_pnl + totals.unrealized_pnl - pos.unrealized_pnl + unrealized;
+            if (total_pnl < -limit.daily_loss_limit)
+            {
+                return RiskResult::REJECTED_LOSS_LIMIT;
+            }
+            if (totals.daily_volume + volume > limit.max_daily_volume)
+            {
+                return RiskResult::REJECTED_VOLUME_LIMIT;
+            }
+        }
+        else if (pos.realized_pnl + unrealized < -limit.daily_loss_limit)
         {
-            rate_limit.timestamps.pop_front();
+            return RiskResult::REJECTED_LOSS_LIMIT;
         }
 
-        if (static_cast<int32_t>(rate_limit.timestamps.size()) >= limit.max_orders_per_sec)
+        if (is_rate_limited(owner, now_ns, orders))
         {
-            return true;
+            return RiskResult::REJECTED_RATE_LIMIT;
         }
 
-        rate_limit.timestamps.push_back(now);
-        return false;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (quotes[i].id != 0 && circuit_breaker_.should_halt_trading(quotes[i].price))
+            {
+                return RiskResult::REJECTED_CIRCUIT_BREAKER;
+            }
+        }
+        return RiskResult::APPROVED;
     }
 
-    void reset_daily_stats()
+    // One second's worth of orders may burst; now_ns is the order's own timestamp
+    bool is_rate_limited(uint32_t trader_id, int64_t now_ns, int64_t orders = 1)
     {
-        for (auto &[trader_id, pos] : positions_)
+        const RiskLimits *limit_ptr = find_limits(trader_id);
+        if (limit_ptr == nullptr)
         {
-            pos.daily_volume = 0;
-            pos.realized_pnl = 0;
-            pos.unrealized_pnl = 0;
+            return true;
         }
 
-        for (auto &[id, limit] : rate_limits_)
+        auto &bucket = rate_limits_[trader_id];
+        if (bucket.rate() != limit_ptr->max_orders_per_sec)
         {
-            limit.count_this_second = 0;
-            limit.timestamps.clear();
+            bucket.configure(limit_ptr->max_orders_per_sec, limit_ptr->max_orders_per_sec);
         }
+        return !bucket.try_acquire(now_ns, orders);
+    }
+
+    void reset_daily_stats()
+    {
+        positions_.for_each([](uint32_t, Position &pos)
+                            {
+                                pos.daily_volume = 0;
+                                pos.realized_pnl = 0;
+                                pos.unrealized_pnl = 0; });
+
+        rate_limits_.for_each([](uint32_t, TokenBucket &bucket)
+                              { bucket.reset(); });
 
         last_trade_price_ = 0;
         circuit_breaker_.resume_trading();
@@ -267,49 +579,121 @@ public:
 
     Position get_position(uint32_t trader_id)
     {
-        auto it = positions_.find(trader_id);
-        if (it == positions_.end())
+        const Position *found = positions_.find(trader_id);
+        if (found == nullptr)
         {
             return Position{0, 0, 0, 0, 0};
         }
 
-        auto pos = it->second;
-        if (last_trade_price_ > 0 && pos.quantity != 0)
-        {
-            pos.unrealized_pnl = (last_trade_price_ - pos.avg_price) * pos.quantity;
-        }
+        auto pos = *found;
+        pos.unrealized_pnl = unrealized_pnl(pos);
         return pos;
     }
 
+    // O(1): unrealized PnL is derived from the mark whenever it is read
     void mark_to_market(Price current_price)
     {
         if (current_price <= 0)
             return;
 
-        for (auto &[trader_id, pos] : positions_)
+        last_trade_price_ = current_price;
+        if (circuit_breaker_.should_halt_trading(current_price))
         {
-            if (pos.quantity != 0)
+        }
+    }
+
+    // Net quantity against its average cost, at the current mark
+    int64_t unrealized_pnl(const Position &pos) const
+    {
+        if (last_trade_price_ <= 0 || pos.quantity == 0)
+            return 0;
+        return (last_trade_price_ - pos.avg_price) * pos.quantity;
+    }
+
+    CircuitBreaker &get_circuit_breaker() { return circuit_breaker_; }
+    Price get_last_trade_price() const { return last_trade_price_; }
+    void set_tick_table(const TickSizeTable *tick_table) { tick_table_ = tick_table; }
+
+    // Positions, limits, rate buckets, mark and breaker, sorted by trader so
+    // equal states give equal bytes. Totals in a SharedRiskService are not
+    // part of it; the service owner persists those.
+    void save_state(SnapshotWriter &out) const
+    {
+        auto save_sorted = [&out](const auto &table, auto value_of)
+        {
+            vector<uint32_t> ids;
+            ids.reserve(table.size());
+            table.for_each([&ids](uint32_t id, const auto &)
+                           { ids.push_back(id); });
+            sort(ids.begin(), ids.end());
+            out.put(static_cast<uint64_t>(ids.size()));
+            for (uint32_t id : ids)
+            {
+                out.put(id);
+                out.put(value_of(*table.find(id)));
+            }
+        };
+        save_sorted(positions_, [](const Position &pos) { return pos; });
+        save_sorted(trader_limits_, [](const RiskLimits &limits) { return limits; });
+        save_sorted(rate_limits_, [](const TokenBucket &bucket) { return bucket.state(); });
+        out.put(last_trade_price_);
+        out.put(circuit_breaker_.state());
+    }
+
+    // Replaces every table; limits are re-published to a shared service
+    bool load_state(SnapshotReader &in)
+    {
+        constexpr uint64_t MAX_ENTRIES = 1ull << 32;
+        uint64_t count = 0;
+        uint32_t id = 0;
+
+        positions_.clear();
+        in.get_count(count, MAX_ENTRIES);
+        for (uint64_t i = 0; i < count && in.ok(); i++)
+        {
+            Position pos{};
+            if (in.get(id) && in.get(pos))
             {
-                pos.unrealized_pnl = (current_price - pos.avg_price) * pos.quantity;
+                positions_[id] = pos;
+            }
+        }
 
-                auto limit_it = trader_limits_.find(trader_id);
-                if (limit_it != trader_limits_.end())
+        trader_limits_.clear();
+        in.get_count(count, MAX_ENTRIES);
+        for (uint64_t i = 0; i < count && in.ok(); i++)
+        {
+            RiskLimits limits{};
+            if (in.get(id) && in.get(limits))
+            {
+                trader_limits_[id] = limits;
+                if (shared_ && shared_->has_trader(id))
                 {
-                    int64_t total_loss = pos.unrealized_pnl + pos.realized_pnl;
-                    if (total_loss < -static_cast<int64_t>(limit_it->second.daily_loss_limit * 0.9))
-                    {
-                    }
+                    shared_->set_trader_limits(id, limits);
                 }
             }
         }
 
-        last_trade_price_ = current_price;
-        if (circuit_breaker_.should_halt_trading(current_price))
+        rate_limits_.clear();
+        in.get_count(count, MAX_ENTRIES);
+        for (uint64_t i = 0; i < count && in.ok(); i++)
+        {
+            TokenBucket::State bucket{};
+            if (in.get(id) && in.get(bucket))
+            {
+                rate_limits_[id].restore(bucket);
+            }
+        }
+
+        CircuitBreaker::State breaker{};
+        in.get(last_trade_price_);
+        if (in.get(breaker))
         {
+            circuit_breaker_.restore(breaker);
         }
+        return in.ok();
     }
 
-    CircuitBreaker &get_circuit_breaker() { return circuit_breaker_; }
-    Price get_last_trade_price() const { return last_trade_price_; }
-    void set_tick_table(const TickSizeTable *tick_table) { tick_table_ = tick_table; }
+    // Route limits and cross-book totals through a shared service from now on
+    void attach_shared_risk(SharedRiskService *shared) { shared_ = shared; }
+    SharedRiskService *get_shared_risk() const { return shared_; }
 };
\ No newline at end of file
@@ -7,6 +7,10 @@
 #include <chrono>
 #include <iostream>
 #include <random>
+#include <array>
+#include <atomic>
+#include <vector>
+#include "rate_limiter.h"
 
 using namespace std;
 using namespace std::chrono;
@@ -178,10 +182,11 @@ public:
     {
         lock_guard<mutex> lock(ip_mutex_);
 
-        // 1. Add session_id to the vector for this IP
-        if (can_create_session(ip))
+        // 1. Add session_id to the vector for this IP, same limit as can_create_session
+        auto &sessions = ip_to_sessions_[ip];
+        if (sessions.size() < MAX_SESSIONS_PER_IP)
         {
-            ip_to_sessions_[ip].push_back(session_id);
+            sessions.push_back(session_id);
         }
     }
 
@@ -195,7 +200,11 @@ public:
         auto it = ip_to_sessions_.find(ip);
         if (it == ip_to_sessions_.end())
             return;
-        it->second.erase(find(it->second.begin(), it->second.end(), session_id));
+        auto session_it = find(it->second.begin(), it->second.end(), session_id);
+        if (session_it != it->second.end())
+        {
+            it->second.erase(session_it);
+        }
         if (it->second.empty())
         {
             ip_to_sessions_.erase(it);
@@ -253,14 +262,14 @@ private:
     uint32_t session_id_;
     string username_;
     string client_ip_;
-    bool is_authenticated_;
+    atomic<bool> is_authenticated_; // read lock-free by the order path
     int64_t last_heartbeat_;
     int64_t login_time_;
 
     bool is_market_maker_;
     bool is_admin_;
 
-    deque<int64_t> message_timestamps_;
+    TokenBucket message_bucket_;
     uint32_t messages_per_second_limit_;
 
     uint64_t total_messages_sent_;
@@ -277,6 +286,13 @@ public:
         auto now = steady_clock::now();
         last_heartbeat_ = duration_cast<milliseconds>(now.time_since_epoch()).count();
         login_time_ = last_heartbeat_;
+        configure_rate_limit();
+    }
+
+    void configure_rate_limit()
+    {
+        uint32_t limit = is_market_maker_ ? 200 : messages_per_second_limit_;
+        message_bucket_.configure(limit, limit);
     }
 
     bool authenticate(const string &password, UserDatabase &user_db)
@@ -285,10 +301,11 @@ public:
 
         if (user_db.authenticate_user(username_, password, is_mm, is_admin))
         {
-            is_authenticated_ = true;
             is_market_maker_ = is_mm;
             is_admin_ = is_admin;
+            configure_rate_limit();
             update_heartbeat();
+            is_authenticated_.store(true, memory_order_release);
             return true;
         }
 
@@ -317,27 +334,17 @@ public:
 
     bool is_rate_limited()
     {
-        // 1. Clean up old timestamps (older than 1 second)
-        // 2. Check if current message count exceeds limit
-        // 3. Add current timestamp if not rate limited
-        // 4. Consider different limits for different user types
-
-        auto now = steady_clock::now();
-        int64_t current_time = duration_cast<milliseconds>(now.time_since_epoch()).count();
-
-        while (!message_timestamps_.empty() &&
-               (current_time - message_timestamps_.front()) > 1000)
-        {
-            message_timestamps_.pop_front();
-        }
+        return is_rate_limited(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+    }
 
-        uint32_t limit = is_market_maker_ ? 200 : messages_per_second_limit_;
-        if (message_timestamps_.size() >= limit)
+    // Market makers get 200 msgs/sec, everyone else messages_per_second_limit_
+    bool is_rate_limited(int64_t now_ns)
+    {
+        if (!message_bucket_.try_acquire(now_ns))
         {
             return true;
         }
 
-        message_timestamps_.push_back(current_time);
         total_messages_sent_++;
         return false;
     }
@@ -363,7 +370,7 @@ public:
     uint32_t get_session_id() const { return session_id_; }
     const string &get_username() const { return username_; }
     const string &get_client_ip() const { return client_ip_; }
-    bool is_authenticated() const { return is_authenticated_; }
+    bool is_authenticated() const { return is_authenticated_.load(memory_order_acquire); }
     bool is_market_maker() const { return is_market_maker_; }
     bool is_admin() const { return is_admin_; }
     int64_t get_login_time() const { return login_time_; }
@@ -374,17 +381,178 @@ public:
     bool can_place_orders() const
     {
 
-        return is_authenticated_ && is_active();
+        return is_authenticated() && is_active();
     }
 
     bool can_cancel_orders() const
     {
-        return is_authenticated_ && is_active();
+        return is_authenticated() && is_active();
     }
 
     bool can_access_market_data() const
     {
-        return is_authenticated_;
+        return is_authenticated();
+    }
+};
+
+// ============= Session Table =============
+// Read-mostly id -> session table for the order path. Session id i lives
+// in slot i % CAPACITY; ids are handed out so no two live sessions share a
+// slot, which makes find() a single acquire load plus an id compare, with
+// no lock and no retry. Writers (create, remove) are serialized by the
+// caller. Removed sessions are retired, not deleted: every registered
+// reader reports a quiescent state between messages (QSBR), and a retired
+// session is freed once all online readers have passed one after its
+// removal, so a pointer found mid-message stays valid until then.
+class SessionTable
+{
+public:
+    static constexpr size_t CAPACITY = 4096; // power of two, comfortably above MAX_SESSIONS
+    static constexpr size_t MAX_READERS = 16;
+    static constexpr uint64_t OFFLINE = 0;
+
+private:
+    static constexpr size_t MASK = CAPACITY - 1;
+
+    struct alignas(64) ReaderState
+    {
+        atomic<uint64_t> epoch{OFFLINE}; // last global epoch seen at a quiescent point
+        atomic<bool> registered{false};
+    };
+
+    struct Retired
+    {
+        uint64_t epoch; // readers must reach this epoch before it is freed
+        unique_ptr<Session> session;
+    };
+
+    array<atomic<Session *>, CAPACITY> slots_;
+    array<ReaderState, MAX_READERS> readers_;
+    atomic<uint64_t> epoch_;
+    vector<Retired> retired_;
+    size_t live_;
+
+public:
+    SessionTable() : epoch_(1), live_(0)
+    {
+        for (auto &slot : slots_)
+        {
+            slot.store(nullptr, memory_order_relaxed);
+        }
+    }
+
+    ~SessionTable()
+    {
+        for (auto &slot : slots_)
+        {
+            delete slot.load(memory_order_relaxed);
+        }
+    }
+
+    SessionTable(const SessionTable &) = delete;
+    SessionTable &operator=(const SessionTable &) = delete;
+
+    // ---- Reader side: any thread, wait-free ----
+
+    Session *find(uint32_t session_id) const
+    {
+        Session *session = slots_[session_id & MASK].load(memory_order_acquire);
+        return session != nullptr && session->get_session_id() == session_id ? session : nullptr;
+    }
+
+    // Returns a reader id, or -1 if every reader slot is taken; the reader starts online
+    int register_reader()
+    {
+        for (size_t i = 0; i < MAX_READERS; i++)
+        {
+            bool expected = false;
+            if (readers_[i].registered.compare_exchange_strong(expected, true))
+            {
+                go_online(static_cast<int>(i));
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    void unregister_reader(int reader)
+    {
+        readers_[reader].epoch.store(OFFLINE, memory_order_release);
+        readers_[reader].registered.store(false, memory_order_release);
+    }
+
+    // Called between messages: no session pointer from before is used after
+    void quiescent(int reader)
+    {
+        readers_[reader].epoch.store(epoch_.load(memory_order_acquire), memory_order_release);
+    }
+
+    // An idle reader goes offline so it does not hold up reclamation
+    void go_offline(int reader) { readers_[reader].epoch.store(OFFLINE, memory_order_release); }
+
+    // The fence orders the epoch store before the reader's next slot load,
+    // or a reclaim could miss a reader that is already looking
+    void go_online(int reader)
+    {
+        quiescent(reader);
+        atomic_thread_fence(memory_order_seq_cst);
+    }
+
+    // ---- Writer side: caller holds the writers' lock ----
+
+    bool slot_free(uint32_t session_id) const { return slots_[session_id & MASK].load(memory_order_relaxed) == nullptr; }
+    size_t size() const { return live_; }
+
+    void publish(unique_ptr<Session> session)
+    {
+        slots_[session->get_session_id() & MASK].store(session.release(), memory_order_release);
+        live_++;
+    }
+
+    // Unlinks the session; it is freed by a later reclaim()
+    bool retire(uint32_t session_id)
+    {
+        auto &slot = slots_[session_id & MASK];
+        Session *session = slot.load(memory_order_relaxed);
+        if (session == nullptr || session->get_session_id() != session_id)
+            return false;
+        slot.store(nullptr, memory_order_seq_cst);
+        live_--;
+        // Readers that see the new epoch also see the empty slot
+        retired_.push_back(Retired{epoch_.fetch_add(1, memory_order_seq_cst) + 1, unique_ptr<Session>(session)});
+        return true;
+    }
+
+    // Frees retired sessions no reader can still hold; returns how many are left
+    size_t reclaim()
+    {
+        uint64_t oldest = UINT64_MAX;
+        for (const ReaderState &reader : readers_)
+        {
+            uint64_t epoch = reader.epoch.load(memory_order_acquire);
+            if (epoch != OFFLINE)
+            {
+                oldest = min(oldest, epoch);
+            }
+        }
+        retired_.erase(remove_if(retired_.begin(), retired_.end(),
+                                 [oldest](const Retired &retired)
+                                 { return retired.epoch <= oldest; }),
+                       retired_.end());
+        return retired_.size();
+    }
+
+    // Slow-path iteration over live sessions, writers' lock held
+    template <typename Fn>
+    void for_each(Fn &&fn) const
+    {
+        for (const auto &slot : slots_)
+        {
+            if (Session *session = slot.load(memory_order_relaxed))
+            {
+                fn(session);
+            }
+        }
     }
 };
 
@@ -392,19 +560,43 @@ public:
 class SessionManager
 {
 private:
-    unordered_map<uint32_t, unique_ptr<Session>> sessions_;
+    SessionTable sessions_;
     unordered_map<string, uint32_t> username_to_session_;
     uint32_t next_session_id_;
-    mutable mutex sessions_mutex_;
+    mutable mutex sessions_mutex_; // writers and slow-path readers only; find_session never takes it
     UserDatabase user_db_;
     IPManager ip_manager_;
 
     static constexpr size_t MAX_SESSIONS = 1000;
     static constexpr size_t MAX_SESSIONS_PER_IP = 10;
 
+    static_assert(MAX_SESSIONS < SessionTable::CAPACITY, "create_session needs a free slot to land on");
+
+    // Caller holds sessions_mutex_
+    void erase_session(Session *session)
+    {
+        uint32_t session_id = session->get_session_id();
+        username_to_session_.erase(session->get_username());
+        ip_manager_.remove_session(session->get_client_ip(), session_id);
+        sessions_.retire(session_id);
+    }
+
 public:
     SessionManager() : next_session_id_(1) {}
 
+    // Persisted across restarts so session ids are never reused
+    uint32_t next_session_id() const
+    {
+        lock_guard<mutex> lock(sessions_mutex_);
+        return next_session_id_;
+    }
+
+    void set_next_session_id(uint32_t session_id)
+    {
+        lock_guard<mutex> lock(sessions_mutex_);
+        next_session_id_ = session_id;
+    }
+
     bool create_user(const string &username, const string &password,
                      bool is_market_maker, bool is_admin, const string &email)
     {
@@ -413,7 +605,9 @@ public:
 
     bool authenticate_session(uint32_t session_id, const string &password)
     {
-        Session *session = get_session(session_id);
+        // Held throughout so the session cannot be removed under us
+        lock_guard<mutex> lock(sessions_mutex_);
+        Session *session = sessions_.find(session_id);
         if (!session)
             return false;
 
@@ -439,6 +633,7 @@ public:
     uint32_t create_session(const string &username, const string &client_ip)
     {
         lock_guard<mutex> lock(sessions_mutex_);
+        sessions_.reclaim();
 
         // 1. Check if max sessions reached globally
         if (sessions_.size() >= MAX_SESSIONS)
@@ -456,23 +651,26 @@ public:
         auto username_it = username_to_session_.find(username);
         if (username_it != username_to_session_.end())
         {
-            uint32_t old_session_id = username_it->second;
-            auto old_session_it = sessions_.find(old_session_id);
-            if (old_session_it != sessions_.end())
+            if (Session *old_session = sessions_.find(username_it->second))
             {
-                ip_manager_.remove_session(old_session_it->second->get_client_ip(), old_session_id);
-                sessions_.erase(old_session_it);
+                erase_session(old_session);
+            }
+            else
+            {
+                username_to_session_.erase(username_it);
             }
-            username_to_session_.erase(username_it);
         }
 
-        // 4. Create new session with unique ID
+        // 4. Create new session with unique ID; ids whose slot is taken are skipped
+        while (next_session_id_ == 0 || !sessions_.slot_free(next_session_id_))
+        {
+            next_session_id_++;
+        }
         uint32_t session_id = next_session_id_++;
-        auto session = make_unique<Session>(session_id, username, client_ip);
 
         // 5. Add to both maps (id->session and username->id)
         username_to_session_[username] = session_id;
-        sessions_[session_id] = std::move(session);
+        sessions_.publish(make_unique<Session>(session_id, username, client_ip));
 
         // 6. Add session to IP tracking
         ip_manager_.add_session(client_ip, session_id);
@@ -480,11 +678,28 @@ public:
         return session_id;
     }
 
+    // Order path: wait-free, from a thread registered with register_reader().
+    // The session stays valid until that reader's next quiescent().
+    Session *find_session(uint32_t session_id) const { return sessions_.find(session_id); }
+
+    int register_reader() { return sessions_.register_reader(); }
+    void unregister_reader(int reader) { sessions_.unregister_reader(reader); }
+    void quiescent(int reader) { sessions_.quiescent(reader); }
+    void go_offline(int reader) { sessions_.go_offline(reader); }
+    void go_online(int reader) { sessions_.go_online(reader); }
+
+    // Frees removed sessions once no reader can hold them; returns how many still wait
+    size_t reclaim_sessions()
+    {
+        lock_guard<mutex> lock(sessions_mutex_);
+        return sessions_.reclaim();
+    }
+
+    // Slow path: the pointer is only safe until the session is removed
     Session *get_session(uint32_t session_id)
     {
         lock_guard<mutex> lock(sessions_mutex_);
-        auto it = sessions_.find(session_id);
-        return (it != sessions_.end()) ? it->second.get() : nullptr;
+        return sessions_.find(session_id);
     }
 
     Session *get_session_by_username(const string &username)
@@ -493,7 +708,7 @@ public:
         auto it = username_to_session_.find(username);
         if (it != username_to_session_.end())
         {
-            return sessions_[it->second].get();
+            return sessions_.find(it->second);
         }
         return nullptr;
     }
@@ -502,59 +717,33 @@ public:
     {
         lock_guard<mutex> lock(sessions_mutex_);
 
-        auto it = sessions_.find(session_id);
-        if (it != sessions_.end())
-        {
-            // Get session info before removing
-            const string &username = it->second->get_username();
-            const string &client_ip = it->second->get_client_ip();
-
-            // Remove from username mapping
-            username_to_session_.erase(username);
-
-            // Remove from IP tracking
-            ip_manager_.remove_session(client_ip, session_id);
+        Session *session = sessions_.find(session_id);
+        if (session == nullptr)
+            return false;
 
-            // Remove session
-            sessions_.erase(it);
-            return true;
-        }
-        return false;
+        erase_session(session);
+        sessions_.reclaim();
+        return true;
     }
 
     size_t cleanup_inactive_sessions()
     {
-
         lock_guard<mutex> lock(sessions_mutex_);
 
-        size_t cleaned_up = 0;
-        auto it = sessions_.begin();
-        while (it != sessions_.end())
+        vector<Session *> inactive;
+        sessions_.for_each([&](Session *session)
+                           {
+                               if (!session->is_active())
+                               {
+                                   inactive.push_back(session);
+                               }
+                           });
+        for (Session *session : inactive)
         {
-            if (!it->second->is_active())
-            {
-                // Get session info before removing
-                const string &username = it->second->get_username();
-                const string &client_ip = it->second->get_client_ip();
-                uint32_t session_id = it->second->get_session_id();
-
-                // Remove from username mapping
-                username_to_session_.erase(username);
-
-                // Remove from IP tracking
-                ip_manager_.remove_session(client_ip, session_id);
-
-                // Remove session
-                it = sessions_.erase(it);
-                cleaned_up++;
-            }
-            else
-            {
-                ++it;
-            }
+            erase_session(session);
         }
-
-        return cleaned_up;
+        sessions_.reclaim();
+        return inactive.size();
     }
 
     size_t active_session_count() const
@@ -567,13 +756,13 @@ public:
     {
         lock_guard<mutex> lock(sessions_mutex_);
         size_t count = 0;
-        for (const auto &[id, session] : sessions_)
-        {
-            if (session->is_authenticated())
-            {
-                count++;
-            }
-        }
+        sessions_.for_each([&](const Session *session)
+                           {
+                               if (session->is_authenticated())
+                               {
+                                   count++;
+                               }
+                           });
         return count;
     }
 
@@ -581,19 +770,20 @@ public:
     {
         lock_guard<mutex> lock(sessions_mutex_);
 
+        size_t authenticated = 0, mm_count = 0, admin_count = 0;
+        sessions_.for_each([&](const Session *session)
+                           {
+                               if (session->is_authenticated())
+                                   authenticated++;
+                               if (session->is_market_maker())
+                                   mm_count++;
+                               if (session->is_admin())
+                                   admin_count++;
+                           });
+
         cout << "\n=== SESSION MANAGER STATISTICS ===" << endl;
         cout << "Total Sessions: " << sessions_.size() << endl;
-        cout << "Authenticated Sessions: " << authenticated_session_count() << endl;
-
-        size_t mm_count = 0, admin_count = 0;
-        for (const auto &[id, session] : sessions_)
-        {
-            if (session->is_market_maker())
-                mm_count++;
-            if (session->is_admin())
-                admin_count++;
-        }
-
+        cout << "Authenticated Sessions: " << authenticated << endl;
         cout << "Market Maker Sessions: " << mm_count << endl;
         cout << "Admin Sessions: " << admin_count << endl;
         cout << "Regular Trader Sessions: " << (sessions_.size() - mm_count - admin_count) << endl;
@@ -601,18 +791,15 @@ public:
 
     vector<uint32_t> get_all_authenticated_sessions() const
     {
-
         lock_guard<mutex> lock(sessions_mutex_);
         vector<uint32_t> authenticated_sessions;
-
-        for (const auto &[id, session] : sessions_)
-        {
-            if (session->is_authenticated())
-            {
-                authenticated_sessions.push_back(id);
-            }
-        }
-
+        sessions_.for_each([&](const Session *session)
+                           {
+                               if (session->is_authenticated())
+                               {
+                                   authenticated_sessions.push_back(session->get_session_id());
+                               }
+                           });
         return authenticated_sessions;
     }
 
@@ -620,15 +807,13 @@ public:
     {
         lock_guard<mutex> lock(sessions_mutex_);
         vector<uint32_t> mm_sessions;
-
-        for (const auto &[id, session] : sessions_)
-        {
-            if (session->is_authenticated() && session->is_market_maker())
-            {
-                mm_sessions.push_back(id);
-            }
-        }
-
+        sessions_.for_each([&](const Session *session)
+                           {
+                               if (session->is_authenticated() && session->is_market_maker())
+                               {
+                                   mm_sessions.push_back(session->get_session_id());
+                               }
+                           });
         return mm_sessions;
     }
 
@@ -0,0 +1,52 @@
+#pragma once
+#include "types.h"
+#include <cstdio>
+
+// Raw little-endian field I/O for snapshot files. Errors are sticky: after
+// the first failed read or write every later call is a no-op and ok()
+// stays false, so callers check once at the end.
+class SnapshotWriter
+{
+private:
+    FILE *file_;
+    bool ok_;
+
+public:
+    explicit SnapshotWriter(FILE *file) : file_(file), ok_(file != nullptr) {}
+
+    template <typename T>
+    void put(const T &value)
+    {
+        static_assert(is_trivially_copyable_v<T>, "snapshot fields are written as raw bytes");
+        ok_ = ok_ && fwrite(&value, sizeof(T), 1, file_) == 1;
+    }
+
+    bool ok() const { return ok_; }
+};
+
+class SnapshotReader
+{
+private:
+    FILE *file_;
+    bool ok_;
+
+public:
+    explicit SnapshotReader(FILE *file) : file_(file), ok_(file != nullptr) {}
+
+    template <typename T>
+    bool get(T &value)
+    {
+        static_assert(is_trivially_copyable_v<T>, "snapshot fields are read as raw bytes");
+        ok_ = ok_ && fread(&value, sizeof(T), 1, file_) == 1;
+        return ok_;
+    }
+
+    // Element counts are bounded so a corrupt file cannot ask for huge allocations
+    bool get_count(uint64_t &count, uint64_t limit)
+    {
+        ok_ = get(count) && count <= limit;
+        return ok_;
+    }
+
+    bool ok() const { return ok_; }
+};
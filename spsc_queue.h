@@ -0,0 +1,122 @@
+#pragma once
+#include "types.h"
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+
+// Spin-wait hint for busy-polling loops
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// Pins the calling thread to one core; a failure leaves it unpinned
+inline void pin_thread_to_core(int core)
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+}
+
+// Busy-poll backoff: pause for a while, then start yielding the core
+inline void idle_backoff(unsigned &spins)
+{
+    if (++spins < 1024)
+    {
+        cpu_relax();
+    }
+    else
+    {
+        this_thread::yield();
+    }
+}
+
+// Bounded single-producer/single-consumer ring. Head and tail sit on their
+// own cache lines and each side keeps a cached copy of the other's index,
+// so the shared lines are only touched when the ring looks full or empty.
+template <typename T>
+class SpscQueue
+{
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    vector<T> buffer_;
+    size_t mask_;
+
+    alignas(CACHE_LINE) atomic<size_t> head_; // next slot to pop, written by consumer
+    size_t cached_tail_;
+
+    alignas(CACHE_LINE) atomic<size_t> tail_; // next slot to push, written by producer
+    size_t cached_head_;
+
+public:
+    explicit SpscQueue(size_t capacity = 65536) : head_(0), cached_tail_(0), tail_(0), cached_head_(0)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        buffer_.resize(size);
+        mask_ = size - 1;
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    bool try_push(const T &item)
+    {
+        size_t tail = tail_.load(memory_order_relaxed);
+        if (tail - cached_head_ > mask_)
+        {
+            cached_head_ = head_.load(memory_order_acquire);
+            if (tail - cached_head_ > mask_)
+                return false;
+        }
+        buffer_[tail & mask_] = item;
+        tail_.store(tail + 1, memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T &item)
+    {
+        size_t head = head_.load(memory_order_relaxed);
+        if (head == cached_tail_)
+        {
+            cached_tail_ = tail_.load(memory_order_acquire);
+            if (head == cached_tail_)
+                return false;
+        }
+        item = buffer_[head & mask_];
+        head_.store(head + 1, memory_order_release);
+        return true;
+    }
+
+    // Consumer, zero-copy: the longest run of queued items contiguous in the
+    // buffer; use them in place, then hand the slots back with consume()
+    size_t peek(const T *&first)
+    {
+        size_t head = head_.load(memory_order_relaxed);
+        if (head == cached_tail_)
+        {
+            cached_tail_ = tail_.load(memory_order_acquire);
+            if (head == cached_tail_)
+                return 0;
+        }
+        size_t index = head & mask_;
+        first = &buffer_[index];
+        return min(cached_tail_ - head, buffer_.size() - index);
+    }
+
+    void consume(size_t count)
+    {
+        head_.store(head_.load(memory_order_relaxed) + count, memory_order_release);
+    }
+
+    bool empty() const { return head_.load(memory_order_acquire) == tail_.load(memory_order_acquire); }
+    size_t size() const { return tail_.load(memory_order_acquire) - head_.load(memory_order_acquire); }
+    size_t capacity() const { return mask_ + 1; }
+};
@@ -1,92 +1,282 @@
 #pragma once
 #include "types.h"
+#include "flat_index.h"
 
+// Pending stops grouped by stop price into two flat sorted vectors of
+// levels, each ordered so the next level to trigger sits at the back. The
+// nearest buy and sell stop prices are cached, so a trade that crosses
+// neither costs two compares. Stops at one price form a FIFO linked through
+// a slot array; each level owns a sentinel slot, so unlinking a stop never
+// touches the level vector and cancel is O(1). The slot is kept by the
+// caller in OrderCold::stop_slot. Levels emptied by cancels are dropped
+// from the back as they surface and compacted once they pile up.
 class StopOrderManager
 {
+public:
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    // Triggered stops in trigger order, valid until the next check_triggered_stops
+    struct TriggeredStops
+    {
+        Order *const *first;
+        Order *const *last;
+
+        Order *const *begin() const { return first; }
+        Order *const *end() const { return last; }
+        size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+    };
+
 private:
-    map<Price, vector<Order *>> buy_stops_;
-    map<Price, vector<Order *>> sell_stops_;
-    unordered_map<OrderId, Order *> stop_lookup_;
+    struct StopLevel
+    {
+        Price stop_price;
+        uint32_t sentinel;
+    };
 
-public:
-    void add_stop_order(Order *order)
+    struct StopSlot
     {
-        if (order->type != OrderType::STOP_LOSS)
-            return;
+        Order *order; // nullptr for sentinels and free slots
+        uint32_t prev;
+        uint32_t next; // doubles as the free-list link
+    };
 
-        if (order->side == Side::BUY)
+    vector<StopLevel> buy_levels_;  // descending stop price
+    vector<StopLevel> sell_levels_; // ascending stop price
+    vector<StopSlot> slots_;
+    uint32_t free_slot_;
+    size_t empty_levels_;
+    Price nearest_buy_stop_;  // lowest pending buy stop
+    Price nearest_sell_stop_; // highest pending sell stop
+    vector<Order *> triggered_;
+    FlatIndex<OrderId, uint32_t> stop_lookup_;
+
+    uint32_t allocate_slot(Order *order)
+    {
+        uint32_t slot = free_slot_;
+        if (slot == NO_SLOT)
         {
-            buy_stops_[order->stop_price].push_back(order);
+            slot = static_cast<uint32_t>(slots_.size());
+            slots_.push_back(StopSlot{nullptr, NO_SLOT, NO_SLOT});
         }
         else
         {
-            sell_stops_[order->stop_price].push_back(order);
+            free_slot_ = slots_[slot].next;
         }
-        stop_lookup_[order->id] = order;
+        slots_[slot] = StopSlot{order, slot, slot};
+        return slot;
     }
 
-    bool remove_stop_order(OrderId order_id)
+    void free_slot(uint32_t slot)
     {
-        auto it = stop_lookup_.find(order_id);
-        if (it == stop_lookup_.end())
-            return false;
+        slots_[slot].order = nullptr;
+        slots_[slot].next = free_slot_;
+        free_slot_ = slot;
+    }
+
+    bool level_empty(const StopLevel &level) const
+    {
+        return slots_[level.sentinel].next == level.sentinel;
+    }
 
-        auto order = it->second;
-        auto &bucket = (order->side == Side::BUY) ? buy_stops_[order->stop_price] : sell_stops_[order->stop_price];
+    void append(uint32_t sentinel, uint32_t slot)
+    {
+        uint32_t last = slots_[sentinel].prev;
+        slots_[slot].prev = last;
+        slots_[slot].next = sentinel;
+        slots_[last].next = slot;
+        slots_[sentinel].prev = slot;
+    }
+
+    // Appends the stop to the level at pos, creating the level first if
+    // pos holds a different price
+    void add_to_levels(vector<StopLevel> &levels, vector<StopLevel>::iterator pos, Price stop, uint32_t slot)
+    {
+        if (pos == levels.end() || pos->stop_price != stop)
+        {
+            uint32_t sentinel = allocate_slot(nullptr);
+            pos = levels.insert(pos, StopLevel{stop, sentinel});
+        }
+        else if (level_empty(*pos))
+        {
+            empty_levels_--;
+        }
+        append(pos->sentinel, slot);
+    }
 
-        auto order_it = find(bucket.begin(), bucket.end(), order);
-        if (order_it != bucket.end())
+    void trim(vector<StopLevel> &levels)
+    {
+        while (!levels.empty() && level_empty(levels.back()))
         {
-            bucket.erase(order_it);
+            free_slot(levels.back().sentinel);
+            levels.pop_back();
+            empty_levels_--;
         }
+    }
 
-        if (bucket.empty())
+    void compact(vector<StopLevel> &levels)
+    {
+        auto drop = [this](const StopLevel &level)
         {
-            if (order->side == Side::BUY)
-            {
-                buy_stops_.erase(order->stop_price);
-            }
-            else
-            {
-                sell_stops_.erase(order->stop_price);
-            }
+            if (!level_empty(level))
+                return false;
+            free_slot(level.sentinel);
+            return true;
+        };
+        levels.erase(remove_if(levels.begin(), levels.end(), drop), levels.end());
+    }
+
+    void refresh_nearest()
+    {
+        trim(buy_levels_);
+        trim(sell_levels_);
+        nearest_buy_stop_ = buy_levels_.empty() ? LLONG_MAX : buy_levels_.back().stop_price;
+        nearest_sell_stop_ = sell_levels_.empty() ? LLONG_MIN : sell_levels_.back().stop_price;
+
+        if (empty_levels_ > 64 && empty_levels_ * 2 > buy_levels_.size() + sell_levels_.size())
+        {
+            compact(buy_levels_);
+            compact(sell_levels_);
+            empty_levels_ = 0;
+        }
+    }
+
+    // Moves a level's stops, oldest first, into triggered_ and frees the level
+    void take_level(const StopLevel &level)
+    {
+        if (level_empty(level))
+        {
+            empty_levels_--;
+        }
+        for (uint32_t slot = slots_[level.sentinel].next; slot != level.sentinel;)
+        {
+            uint32_t next = slots_[slot].next;
+            Order *order = slots_[slot].order;
+            triggered_.push_back(order);
+            stop_lookup_.erase(order->id);
+            free_slot(slot);
+            slot = next;
         }
+        free_slot(level.sentinel);
+    }
+
+public:
+    StopOrderManager()
+        : free_slot_(NO_SLOT), empty_levels_(0), nearest_buy_stop_(LLONG_MAX), nearest_sell_stop_(LLONG_MIN)
+    {
+        triggered_.reserve(256);
+    }
+
+    // Returns the stop's slot, or NO_SLOT if the order is not a stop
+    uint32_t add_stop_order(Order *order, Price stop)
+    {
+        if (order->type != OrderType::STOP_LOSS)
+            return NO_SLOT;
+
+        uint32_t slot = allocate_slot(order);
+        if (order->side == Side::BUY)
+        {
+            auto pos = partition_point(buy_levels_.begin(), buy_levels_.end(),
+                                       [stop](const StopLevel &level)
+                                       { return level.stop_price > stop; });
+            add_to_levels(buy_levels_, pos, stop, slot);
+        }
+        else
+        {
+            auto pos = partition_point(sell_levels_.begin(), sell_levels_.end(),
+                                       [stop](const StopLevel &level)
+                                       { return level.stop_price < stop; });
+            add_to_levels(sell_levels_, pos, stop, slot);
+        }
+        stop_lookup_[order->id] = slot;
+        refresh_nearest();
+        return slot;
+    }
+
+    // O(1): unlinks the stop; a level it leaves empty is dropped later
+    bool remove_stop_order(Order *order, uint32_t slot)
+    {
+        if (slot == NO_SLOT || slot >= slots_.size() || slots_[slot].order != order)
+            return false;
+
+        uint32_t prev = slots_[slot].prev;
+        uint32_t next = slots_[slot].next;
+        slots_[prev].next = next;
+        slots_[next].prev = prev;
+        free_slot(slot);
+        stop_lookup_.erase(order->id);
 
-        stop_lookup_.erase(it);
+        // Both neighbours are the sentinel once the last stop is gone
+        if (prev == next)
+        {
+            empty_levels_++;
+            refresh_nearest();
+        }
         return true;
     }
 
-    vector<Order *> check_triggered_stops(Price last_trade_price)
+    bool remove_stop_order(OrderId order_id)
     {
-        vector<Order *> triggered_orders;
+        const uint32_t *slot = stop_lookup_.find(order_id);
+        if (slot == nullptr)
+            return false;
+        return remove_stop_order(slots_[*slot].order, *slot);
+    }
 
-        auto buy_end = buy_stops_.upper_bound(last_trade_price);
-        for (auto it = buy_stops_.begin(); it != buy_end; ++it)
+    // Buy stops at or below the trade price trigger, then sell stops at or
+    // above it, each in ascending stop price and FIFO within a price
+    TriggeredStops check_triggered_stops(Price last_trade_price)
+    {
+        triggered_.clear();
+        if (last_trade_price < nearest_buy_stop_ && last_trade_price > nearest_sell_stop_)
         {
-            for (auto order : it->second)
-            {
-                triggered_orders.push_back(order);
-                stop_lookup_.erase(order->id);
-            }
+            return TriggeredStops{triggered_.data(), triggered_.data()};
         }
-        buy_stops_.erase(buy_stops_.begin(), buy_end);
 
-        auto sell_start = sell_stops_.lower_bound(last_trade_price);
-        for (auto it = sell_start; it != sell_stops_.end(); ++it)
+        auto buy_split = partition_point(buy_levels_.begin(), buy_levels_.end(),
+                                         [last_trade_price](const StopLevel &level)
+                                         { return level.stop_price > last_trade_price; });
+        for (auto it = buy_levels_.end(); it != buy_split;)
         {
-            for (auto order : it->second)
+            take_level(*--it);
+        }
+        buy_levels_.erase(buy_split, buy_levels_.end());
+
+        auto sell_split = partition_point(sell_levels_.begin(), sell_levels_.end(),
+                                          [last_trade_price](const StopLevel &level)
+                                          { return level.stop_price < last_trade_price; });
+        for (auto it = sell_split; it != sell_levels_.end(); ++it)
+        {
+            take_level(*it);
+        }
+        sell_levels_.erase(sell_split, sell_levels_.end());
+
+        refresh_nearest();
+        return TriggeredStops{triggered_.data(), triggered_.data() + triggered_.size()};
+    }
+
+    // Pending stops, buys then sells, each side in trigger order and FIFO
+    // within a price; re-adding them in this order rebuilds the same queues
+    template <typename Fn>
+    void for_each_pending(Fn &&fn) const
+    {
+        for (const auto *levels : {&buy_levels_, &sell_levels_})
+        {
+            for (auto it = levels->rbegin(); it != levels->rend(); ++it)
             {
-                triggered_orders.push_back(order);
-                stop_lookup_.erase(order->id);
+                for (uint32_t slot = slots_[it->sentinel].next; slot != it->sentinel; slot = slots_[slot].next)
+                {
+                    fn(slots_[slot].order, it->stop_price);
+                }
             }
         }
-        sell_stops_.erase(sell_start, sell_stops_.end());
-
-        return triggered_orders;
     }
 
     size_t pending_stop_count() const
     {
         return stop_lookup_.size();
     }
-};
\ No newline at end of file
+
+    Price nearest_buy_stop() const { return nearest_buy_stop_; }
+    Price nearest_sell_stop() const { return nearest_sell_stop_; }
+};
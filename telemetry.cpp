@@ -0,0 +1,160 @@
+#include "telemetry.h"
+#include "order_book.h"
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr char MAGIC[8] = "ENGTLM";
+    constexpr int READ_ATTEMPTS = 1000;
+
+    // shm_open wants exactly one leading slash
+    string shm_name(const string &name)
+    {
+        return name.empty() || name[0] != '/' ? "/" + name : name;
+    }
+
+    int64_t system_time_ns()
+    {
+        return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+    }
+}
+
+TelemetrySampler::TelemetrySampler(const string &name, int64_t interval_ns)
+    : name_(shm_name(name)), interval_ns_(max<int64_t>(interval_ns, 1000000)), segment_(nullptr), stopping_(false),
+      samples_(0)
+{
+}
+
+TelemetrySampler::~TelemetrySampler()
+{
+    stop();
+}
+
+bool TelemetrySampler::add_book(const OrderBook &book)
+{
+    if (segment_ != nullptr || books_.size() >= TelemetrySegment::MAX_BOOKS)
+        return false;
+    books_.push_back(&book);
+    return true;
+}
+
+bool TelemetrySampler::start()
+{
+    if (segment_ != nullptr)
+        return false;
+
+    int fd = shm_open(name_.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+        return false;
+    if (ftruncate(fd, sizeof(TelemetrySegment)) != 0)
+    {
+        close(fd);
+        return false;
+    }
+    void *mapping = mmap(nullptr, sizeof(TelemetrySegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+
+    segment_ = static_cast<TelemetrySegment *>(mapping);
+    sample();
+    stopping_ = false;
+    worker_ = thread(&TelemetrySampler::run, this);
+    return true;
+}
+
+void TelemetrySampler::stop()
+{
+    if (segment_ == nullptr)
+        return;
+
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    if (worker_.joinable())
+    {
+        worker_.join();
+    }
+
+    // The segment stays behind for readers; the next run reuses it
+    sample();
+    munmap(segment_, sizeof(TelemetrySegment));
+    segment_ = nullptr;
+}
+
+void TelemetrySampler::sample()
+{
+    // Starting from whatever a previous writer left, crashed mid-update included
+    uint64_t sequence = __atomic_load_n(&segment_->sequence, __ATOMIC_RELAXED) | 1;
+    __atomic_store_n(&segment_->sequence, sequence, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy(segment_->magic, MAGIC, sizeof(MAGIC));
+    segment_->version = TelemetrySegment::VERSION;
+    segment_->book_count = static_cast<uint32_t>(books_.size());
+    segment_->samples = ++samples_;
+    segment_->sample_time_ns = system_time_ns();
+    segment_->interval_ns = interval_ns_;
+    for (size_t i = 0; i < books_.size(); i++)
+    {
+        books_[i]->sample_telemetry(segment_->books[i]);
+    }
+
+    __atomic_store_n(&segment_->sequence, sequence + 1, __ATOMIC_RELEASE);
+}
+
+void TelemetrySampler::run()
+{
+    // Only runs when a core would otherwise idle; stays SCHED_OTHER where refused
+    sched_param param{};
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+
+    unique_lock<mutex> lock(mutex_);
+    while (!wake_.wait_for(lock, nanoseconds(interval_ns_), [this] { return stopping_; }))
+    {
+        sample();
+    }
+}
+
+bool read_telemetry(const string &name, TelemetrySegment &out)
+{
+    int fd = shm_open(shm_name(name).c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(TelemetrySegment))
+    {
+        close(fd);
+        return false;
+    }
+    void *mapping = mmap(nullptr, sizeof(TelemetrySegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+
+    const TelemetrySegment *segment = static_cast<const TelemetrySegment *>(mapping);
+    bool consistent = false;
+    for (int attempt = 0; attempt < READ_ATTEMPTS && !consistent; attempt++)
+    {
+        uint64_t before = __atomic_load_n(&segment->sequence, __ATOMIC_ACQUIRE);
+        if (before & 1)
+        {
+            this_thread::yield();
+            continue;
+        }
+        memcpy(&out, segment, sizeof(TelemetrySegment));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        consistent = __atomic_load_n(&segment->sequence, __ATOMIC_RELAXED) == before;
+    }
+    munmap(mapping, sizeof(TelemetrySegment));
+
+    return consistent && memcmp(out.magic, MAGIC, sizeof(MAGIC)) == 0 && out.version == TelemetrySegment::VERSION;
+}
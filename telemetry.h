@@ -0,0 +1,143 @@
+#pragma once
+#include "types.h"
+#include "risk_manager.h"
+#include <condition_variable>
+#include <thread>
+
+// Single-writer counter any thread may read. The owning thread updates it
+// with a plain load and store, no locked instruction, so a bump costs what
+// a uint64_t increment does; readers see a value at most one update old.
+class RelaxedCounter
+{
+private:
+    atomic<uint64_t> value_{0};
+
+public:
+    RelaxedCounter &operator++()
+    {
+        value_.store(value_.load(memory_order_relaxed) + 1, memory_order_relaxed);
+        return *this;
+    }
+    void operator++(int) { ++*this; }
+    RelaxedCounter &operator+=(uint64_t n)
+    {
+        value_.store(value_.load(memory_order_relaxed) + n, memory_order_relaxed);
+        return *this;
+    }
+    void set(uint64_t value) { value_.store(value, memory_order_relaxed); }
+    operator uint64_t() const { return value_.load(memory_order_relaxed); }
+};
+
+// USDT probes, compiled in with -DENGINE_USDT (make USDT=1). Each is a nop
+// plus a .note.stapsdt entry, the format systemtap's <sys/sdt.h> emits, so
+// perf (perf probe sdt_matching_engine:*), bpftrace and bcc find them
+// without that header being installed. The argument is one 64-bit value.
+#ifdef ENGINE_USDT
+#define ENGINE_PROBE(name, arg)                                                              \
+    __asm__ __volatile__("990: nop\n"                                                        \
+                         ".pushsection .note.stapsdt,\"?\",\"note\"\n"                       \
+                         ".balign 4\n"                                                        \
+                         ".4byte 992f-991f, 994f-993f, 3\n"                                   \
+                         "991: .asciz \"stapsdt\"\n"                                          \
+                         "992: .balign 4\n"                                                   \
+                         "993: .8byte 990b\n"                                                 \
+                         ".8byte _.stapsdt.base\n"                                            \
+                         ".8byte 0\n"                                                         \
+                         ".asciz \"matching_engine\"\n"                                       \
+                         ".asciz \"" #name "\"\n"                                             \
+                         ".asciz \"8@%[probe_arg]\"\n"                                        \
+                         "994: .balign 4\n"                                                   \
+                         ".popsection\n"                                                      \
+                         ".ifndef _.stapsdt.base\n"                                           \
+                         ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+                         ".weak _.stapsdt.base\n"                                             \
+                         ".hidden _.stapsdt.base\n"                                           \
+                         "_.stapsdt.base: .space 1\n"                                         \
+                         ".size _.stapsdt.base, 1\n"                                          \
+                         ".popsection\n"                                                      \
+                         ".endif\n"                                                           \
+                         :                                                                    \
+                         : [probe_arg] "r"(static_cast<uint64_t>(arg)))
+#else
+#define ENGINE_PROBE(name, arg) ((void)0)
+#endif
+
+// One book's counters and gauges as the sampler last saw them
+struct TelemetryBook
+{
+    uint64_t orders;
+    uint64_t trades;
+    uint64_t volume;
+    uint64_t cancelled;
+    uint64_t stops_triggered;
+    uint64_t risk_rejected;
+    uint64_t modified;
+    uint64_t risk_rejects[RiskManager::RESULT_COUNT]; // by RiskResult; APPROVED stays 0
+    // Gauges, as of the end of the book's last message
+    uint64_t pool_allocated;
+    uint64_t pool_capacity;
+    uint64_t bid_levels;
+    uint64_t ask_levels;
+    uint64_t indexed_orders; // resting orders and pending stops
+    uint64_t pending_stops;
+};
+
+// Layout of the shared-memory segment. The sampler is its only writer and
+// guards each update with a seqlock; readers copy it out and retry while
+// the sequence was odd or moved.
+struct TelemetrySegment
+{
+    static constexpr size_t MAX_BOOKS = 64;
+    static constexpr uint32_t VERSION = 1;
+
+    char magic[8]; // "ENGTLM\0\0"
+    uint32_t version;
+    uint32_t book_count;
+    uint64_t sequence; // seqlock word, a plain shared mapping so __atomic builtins
+    uint64_t samples;
+    int64_t sample_time_ns; // system clock
+    int64_t interval_ns;
+    TelemetryBook books[MAX_BOOKS];
+};
+
+class OrderBook;
+
+// Low-priority thread (SCHED_IDLE where allowed) that copies the books'
+// counters into a POSIX shared-memory segment every interval. It only reads
+// relaxed atomics, so the matcher threads never wait on it or take a
+// locked instruction for it. Books are added before start() and must
+// outlive the sampler.
+class TelemetrySampler
+{
+private:
+    string name_;
+    int64_t interval_ns_;
+    vector<const OrderBook *> books_;
+    TelemetrySegment *segment_;
+    mutex mutex_;
+    condition_variable wake_;
+    bool stopping_;
+    uint64_t samples_;
+    thread worker_;
+
+    void sample();
+    void run();
+
+public:
+    explicit TelemetrySampler(const string &name, int64_t interval_ns = 100000000);
+    ~TelemetrySampler();
+
+    TelemetrySampler(const TelemetrySampler &) = delete;
+    TelemetrySampler &operator=(const TelemetrySampler &) = delete;
+
+    // False once MAX_BOOKS are registered or after start()
+    bool add_book(const OrderBook &book);
+    // Creates the segment (shm_open name, e.g. "/engine") and starts sampling
+    bool start();
+    // Takes one last sample, so the segment ends with the books' final state
+    void stop();
+};
+
+// Copies a consistent snapshot of the segment called name; false when it
+// does not exist or is not a telemetry segment
+bool read_telemetry(const string &name, TelemetrySegment &out);
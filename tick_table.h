@@ -1,24 +1,74 @@
 #pragma once
 #include "types.h"
 
+// Tick bands kept as flat sorted arrays padded to MAX_RULES, so the band for
+// a price is a branchless count over a few cache lines rather than a scan.
+// Every valid tick also has a dense index (ticks counted from the lowest
+// band), which lets an array ladder use one slot per tick. Everything is
+// constexpr, so fixed schedules such as the Rule 612 defaults can be built
+// and checked at compile time.
 class TickSizeTable
 {
+public:
+    static constexpr size_t MAX_RULES = 16;
+    static constexpr int64_t NO_TICK = -1;
+
 private:
-    struct TickRule
+    static constexpr Price UNUSED = LLONG_MAX;
+
+    size_t rule_count_;
+    Price min_price_[MAX_RULES];
+    Price max_price_[MAX_RULES];
+    Price tick_size_[MAX_RULES];
+    Price first_tick_[MAX_RULES]; // lowest multiple of the tick inside the band
+    int64_t base_index_[MAX_RULES];
+
+    // Index of the last band whose key is <= value, or -1
+    static constexpr int64_t band_of(const int64_t (&keys)[MAX_RULES], int64_t value)
+    {
+        int64_t count = 0;
+        for (size_t i = 0; i < MAX_RULES; ++i)
+        {
+            count += (value >= keys[i]);
+        }
+        return count - 1;
+    }
+
+    constexpr int64_t band_for_price(Price price) const
     {
-        Price min_price;
-        Price max_price;
-        Price tick_size;
+        int64_t band = band_of(min_price_, price);
+        return (band >= 0 && band < static_cast<int64_t>(rule_count_) && price <= max_price_[band]) ? band : -1;
+    }
 
-        TickRule(Price min_p, Price max_p, Price tick)
-            : min_price(min_p), max_price(max_p), tick_size(tick) {}
-    };
+    constexpr void rebuild_index()
+    {
+        int64_t next_index = 0;
+        for (size_t i = 0; i < MAX_RULES; ++i)
+        {
+            if (i >= rule_count_)
+            {
+                first_tick_[i] = UNUSED;
+                base_index_[i] = UNUSED;
+                continue;
+            }
 
-    vector<TickRule> rules_;
+            Price tick = tick_size_[i];
+            first_tick_[i] = ((min_price_[i] + tick - 1) / tick) * tick;
+            base_index_[i] = next_index;
+            Price last_tick = (max_price_[i] / tick) * tick;
+            if (last_tick >= first_tick_[i])
+            {
+                next_index += (last_tick - first_tick_[i]) / tick + 1;
+            }
+        }
+    }
 
 public:
-    TickSizeTable()
+    // NYSE/NASDAQ Regulation NMS Rule 612 defaults
+    constexpr TickSizeTable()
+        : rule_count_(0), min_price_{}, max_price_{}, tick_size_{}, first_tick_{}, base_index_{}
     {
+        clear();
         add_rule(1, 99, 1);
         add_rule(100, 999, 1);
         add_rule(1000, 4999, 1);
@@ -29,95 +79,128 @@ public:
         add_rule(1000000, LLONG_MAX, 100);
     }
 
-    void add_rule(Price min_price, Price max_price, Price tick_size)
+    constexpr void clear()
+    {
+        rule_count_ = 0;
+        for (size_t i = 0; i < MAX_RULES; ++i)
+        {
+            min_price_[i] = UNUSED;
+            max_price_[i] = UNUSED;
+            tick_size_[i] = 1;
+        }
+        rebuild_index();
+    }
+
+    constexpr void add_rule(Price min_price, Price max_price, Price tick_size)
     {
         if (min_price > max_price || tick_size <= 0 || min_price < 0)
         {
             throw std::invalid_argument("Invalid tick rule parameters");
         }
 
-        for (const auto &rule : rules_)
+        for (size_t i = 0; i < rule_count_; ++i)
         {
-            if (!(max_price < rule.min_price || min_price > rule.max_price))
+            if (!(max_price < min_price_[i] || min_price > max_price_[i]))
             {
                 throw std::invalid_argument("Overlapping tick rule ranges not allowed");
             }
         }
 
-        rules_.emplace_back(min_price, max_price, tick_size);
-        sort(rules_.begin(), rules_.end(),
-             [](const TickRule &a, const TickRule &b)
-             {
-                 return a.min_price < b.min_price;
-             });
+        if (rule_count_ == MAX_RULES)
+        {
+            throw std::length_error("Too many tick rules");
+        }
+
+        // Insertion keeps the bands sorted by min_price
+        size_t pos = rule_count_;
+        while (pos > 0 && min_price_[pos - 1] > min_price)
+        {
+            min_price_[pos] = min_price_[pos - 1];
+            max_price_[pos] = max_price_[pos - 1];
+            tick_size_[pos] = tick_size_[pos - 1];
+            --pos;
+        }
+        min_price_[pos] = min_price;
+        max_price_[pos] = max_price;
+        tick_size_[pos] = tick_size;
+        rule_count_++;
+        rebuild_index();
     }
 
-    Price round_to_tick(Price price) const
+    constexpr Price round_to_tick(Price price) const
     {
         if (price <= 0)
             return 0;
 
-        for (const auto &rule : rules_)
-        {
-            if (rule.min_price <= price && rule.max_price >= price)
-            {
-                Price half_tick = rule.tick_size / 2;
-                return ((price + half_tick) / rule.tick_size) * rule.tick_size;
-            }
-        }
+        int64_t band = band_for_price(price);
+        if (band < 0)
+            return 0;
 
-        return 0;
+        Price tick = tick_size_[band];
+        return ((price + tick / 2) / tick) * tick;
     }
 
-    bool is_valid_price(Price price) const
+    constexpr bool is_valid_price(Price price) const
     {
         return price == round_to_tick(price);
     }
 
-    Price get_tick_size(Price price) const
+    constexpr Price get_tick_size(Price price) const
     {
         if (price <= 0)
             return 0;
 
-        for (const auto &rule : rules_)
-        {
-            if (rule.min_price <= price && rule.max_price >= price)
-            {
-                return rule.tick_size;
-            }
-        }
-
-        return 0;
+        int64_t band = band_for_price(price);
+        return band < 0 ? 0 : tick_size_[band];
     }
 
-    Price get_next_tick_up(Price price) const
+    constexpr Price get_next_tick_up(Price price) const
     {
-        Price tick = get_tick_size(price);
-        if (tick == 0)
-            return 0;
-
         Price rounded_price = round_to_tick(price);
         if (rounded_price == 0)
             return 0;
 
-        Price next_price = rounded_price + tick;
-        return round_to_tick(next_price);
+        return round_to_tick(rounded_price + get_tick_size(price));
     }
 
-    Price get_next_tick_down(Price price) const
+    constexpr Price get_next_tick_down(Price price) const
     {
-        Price tick = get_tick_size(price);
-        if (tick == 0)
-            return 0;
-
         Price rounded_price = round_to_tick(price);
         if (rounded_price == 0)
             return 0;
 
-        Price next_price = rounded_price - tick;
+        Price next_price = rounded_price - get_tick_size(price);
         return next_price > 0 ? round_to_tick(next_price) : 0;
     }
 
+    // Dense index of a price that sits exactly on a tick, or NO_TICK
+    constexpr int64_t tick_index(Price price) const
+    {
+        if (price <= 0)
+            return NO_TICK;
+
+        int64_t band = band_for_price(price);
+        if (band < 0)
+            return NO_TICK;
+
+        Price offset = price - first_tick_[band];
+        Price tick = tick_size_[band];
+        if (offset < 0 || offset % tick != 0)
+            return NO_TICK;
+        return base_index_[band] + offset / tick;
+    }
+
+    // Inverse of tick_index for any index the table has assigned
+    constexpr Price price_at(int64_t index) const
+    {
+        int64_t band = band_of(base_index_, index);
+        if (index < 0 || band < 0 || band >= static_cast<int64_t>(rule_count_))
+            return 0;
+        return first_tick_[band] + (index - base_index_[band]) * tick_size_[band];
+    }
+
+    size_t rule_count() const { return rule_count_; }
+
     void print_rules() const
     {
         cout << "\n╔══════════════════════════════════════╗" << endl;
@@ -126,22 +209,34 @@ public:
         cout << "Based on NYSE/NASDAQ Regulation NMS Rule 612\n"
              << endl;
 
-        for (size_t i = 0; i < rules_.size(); ++i)
+        for (size_t i = 0; i < rule_count_; ++i)
         {
-            const auto &rule = rules_[i];
             cout << "  Rule " << (i + 1) << ": $"
-                 << fixed << setprecision(2) << (rule.min_price / 100.0);
+                 << fixed << setprecision(2) << (min_price_[i] / 100.0);
 
-            if (rule.max_price == LLONG_MAX)
+            if (max_price_[i] == LLONG_MAX)
             {
-                cout << "+ -> $" << (rule.tick_size / 100.0) << " tick" << endl;
+                cout << "+ -> $" << (tick_size_[i] / 100.0) << " tick" << endl;
             }
             else
             {
-                cout << " - $" << (rule.max_price / 100.0)
-                     << " -> $" << (rule.tick_size / 100.0) << " tick" << endl;
+                cout << " - $" << (max_price_[i] / 100.0)
+                     << " -> $" << (tick_size_[i] / 100.0) << " tick" << endl;
             }
         }
         cout << endl;
     }
-};
\ No newline at end of file
+};
+
+namespace tick_checks
+{
+    constexpr TickSizeTable NMS_TICKS{};
+    static_assert(NMS_TICKS.round_to_tick(99999) == 99999, "tick 1 band");
+    static_assert(NMS_TICKS.round_to_tick(100003) == 100005, "tick 5 band rounds half up");
+    static_assert(NMS_TICKS.get_next_tick_up(100000) == 100005, "next tick up");
+    static_assert(NMS_TICKS.get_next_tick_down(1000000) == 999900, "next tick down crosses bands");
+    static_assert(NMS_TICKS.tick_index(1) == 0, "first tick");
+    static_assert(NMS_TICKS.tick_index(100005) == NMS_TICKS.tick_index(100000) + 1, "dense across ticks");
+    static_assert(NMS_TICKS.price_at(NMS_TICKS.tick_index(500010)) == 500010, "index round trip");
+    static_assert(NMS_TICKS.tick_index(100003) == TickSizeTable::NO_TICK, "off-tick price");
+}
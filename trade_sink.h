@@ -0,0 +1,118 @@
+#pragma once
+#include "types.h"
+
+// Non-owning reference to whatever consumes trades as the book produces
+// them: a lambda, a TradeBuffer, a TradeSpanSink or any other callable
+// taking const Trade &. Two pointers, passed by value, never allocates.
+class TradeSink
+{
+private:
+    void *ctx_;
+    void (*emit_)(void *, const Trade &);
+
+public:
+    template <typename Fn, typename = enable_if_t<!is_same_v<decay_t<Fn>, TradeSink>>>
+    TradeSink(Fn &fn)
+        : ctx_(const_cast<void *>(static_cast<const void *>(&fn))),
+          emit_([](void *ctx, const Trade &trade)
+                { (*static_cast<Fn *>(ctx))(trade); })
+    {
+    }
+
+    void operator()(const Trade &trade) const { emit_(ctx_, trade); }
+};
+
+// Reusable trade buffer, cleared between orders so its storage is reused
+class TradeBuffer
+{
+private:
+    vector<Trade> trades_;
+    size_t high_water_;
+
+public:
+    TradeBuffer(size_t capacity = 1000) : high_water_(0) { trades_.reserve(capacity); }
+
+    void operator()(const Trade &trade)
+    {
+        trades_.push_back(trade);
+        high_water_ = max(high_water_, trades_.size());
+    }
+
+    void clear() { trades_.clear(); }
+    bool empty() const { return trades_.empty(); }
+    size_t size() const { return trades_.size(); }
+    size_t capacity() const { return trades_.capacity(); }
+    size_t high_water() const { return high_water_; }
+    const Trade &back() const { return trades_.back(); }
+    const Trade *begin() const { return trades_.data(); }
+    const Trade *end() const { return trades_.data() + trades_.size(); }
+};
+
+// Writes into caller-owned storage; trades past capacity are counted, not stored
+class TradeSpanSink
+{
+private:
+    Trade *data_;
+    size_t capacity_;
+    size_t size_;
+    size_t dropped_;
+
+public:
+    TradeSpanSink(Trade *data, size_t capacity) : data_(data), capacity_(capacity), size_(0), dropped_(0) {}
+
+    void operator()(const Trade &trade)
+    {
+        if (size_ < capacity_)
+        {
+            data_[size_++] = trade;
+        }
+        else
+        {
+            dropped_++;
+        }
+    }
+
+    void reset()
+    {
+        size_ = 0;
+        dropped_ = 0;
+    }
+    size_t size() const { return size_; }
+    size_t dropped() const { return dropped_; }
+    const Trade *begin() const { return data_; }
+    const Trade *end() const { return data_ + size_; }
+};
+
+// Order-sensitive FNV-1a digest of a trade stream, so two runs can be
+// checked for identical output without keeping the trades
+class TradeChecksum
+{
+private:
+    uint64_t hash_;
+    uint64_t count_;
+
+    void mix(uint64_t value)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            hash_ ^= (value >> (i * 8)) & 0xff;
+            hash_ *= 1099511628211ull;
+        }
+    }
+
+public:
+    TradeChecksum() : hash_(14695981039346656037ull), count_(0) {}
+
+    void operator()(const Trade &trade)
+    {
+        mix(trade.buy_id);
+        mix(trade.sell_id);
+        mix(static_cast<uint64_t>(trade.price));
+        mix(static_cast<uint64_t>(trade.quantity));
+        mix(static_cast<uint64_t>(trade.timestamp));
+        count_++;
+    }
+
+    uint64_t value() const { return hash_; }
+    uint64_t count() const { return count_; }
+};
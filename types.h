@@ -15,6 +15,9 @@
 #include <numeric>
 #include <mutex>
 #include <stack>
+#include <climits>
+#include <atomic>
+#include <cassert>
 
 using namespace std;
 using namespace std::chrono;
@@ -23,13 +26,13 @@ using OrderId = uint64_t;
 using Price = int64_t;
 using Quantity = int64_t;
 
-enum class Side
+enum class Side : uint8_t
 {
     BUY,
     SELL
 };
 
-enum class OrderType
+enum class OrderType : uint8_t
 {
     GTC,
     IOC,
@@ -37,38 +40,58 @@ enum class OrderType
     MARKET,
     STOP_LOSS,
     ICEBERG,
+    AON_IOC, // all-or-none IOC: fills in full now or cancels, self-trade as IOC
 };
 
+constexpr uint32_t NO_ORDER_SLOT = UINT32_MAX;
+constexpr Quantity MAX_ORDER_QUANTITY = INT32_MAX;
+
+// Hot part of an order: everything the matching loops read or write, packed
+// into 32 bytes so two share a cache line. Queue links are OrderStore slots
+// rather than pointers; the rest of the order lives in OrderCold.
 struct Order
 {
     OrderId id;
+    int32_t display;   // visible quantity
+    int32_t remaining; // untraded quantity: the displayed part plus an iceberg's hidden reserve
+    uint32_t prev;     // intrusive queue links, owned by the PriceLevel
+    uint32_t next;
+    uint32_t ownerID;
     Side side;
-    Price price;
-    Price stop_price;
-    Quantity quantity;
-    Quantity remaining;
-    Quantity display;
-    Quantity display_size;
     OrderType type;
-    int64_t timestamp;
-    uint32_t ownerID;
-    bool is_triggered;
-    OrderId parent_id;
     bool is_market_maker;
-    uint32_t session_id;
+    bool is_triggered;
 
-    Order() : id(0), side(Side::BUY), price(0), stop_price(0), quantity(0),
-              remaining(0), display(0), display_size(0), type(OrderType::GTC),
-              timestamp(0), ownerID(0), is_triggered(false), parent_id(0) {}
+    Order() : id(0), display(0), remaining(0), prev(NO_ORDER_SLOT), next(NO_ORDER_SLOT), ownerID(0),
+              side(Side::BUY), type(OrderType::GTC), is_market_maker(false), is_triggered(false) {}
+};
+static_assert(sizeof(Order) == 32, "hot order record must stay at 32 bytes");
 
-    Order(OrderId id, Side side, Price price, Price stop_price, Quantity qty,
-          Quantity disp, Quantity display_size, OrderType type, uint32_t ownerID, uint32_t sessionID = 0)
-        : id(id), side(side), price(price), stop_price(stop_price), quantity(qty),
-          remaining(qty), display(disp), display_size(display_size), type(type),
-          ownerID(ownerID), is_triggered(false), parent_id(0), session_id(sessionID)
-    {
-        timestamp = duration_cast<nanoseconds>(high_resolution_clock::now().time_since_epoch()).count();
-    }
+// Attributes read at entry, cancel, stop trigger and iceberg refill only,
+// stored in a side array indexed by the same pool slot as the hot record
+struct OrderCold
+{
+    Price price = 0;
+    Price stop_price = 0;
+    Quantity quantity = 0;
+    Quantity display_size = 0;
+    int64_t timestamp = 0;
+    OrderId parent_id = 0;
+    uint32_t session_id = 0;
+    uint32_t stop_slot = UINT32_MAX; // StopOrderManager slot while the stop is pending
+    uint32_t owner_prev = NO_ORDER_SLOT; // links in the owner's list of live orders
+    uint32_t owner_next = NO_ORDER_SLOT;
+};
+
+// One quote of an OrderBook::replace_quotes batch: cancels replaces_id if
+// it is still live, then enters a GTC limit order unless id is 0
+struct QuoteUpdate
+{
+    OrderId replaces_id;
+    OrderId id;
+    Side side;
+    Price price;
+    Quantity quantity;
 };
 
 struct Trade